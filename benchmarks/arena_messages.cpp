@@ -0,0 +1,92 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unary echo of a message made of many small nested messages, with the
+// request and reply on the heap or on the call's arena.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/arena.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace rpc = easy_grpc;
+
+namespace {
+bench_arena::Tree make_tree(int nodes, int leaves) {
+  bench_arena::Tree result;
+  for (int i = 0; i < nodes; ++i) {
+    auto node = result.add_nodes();
+    node->set_name("node_" + std::to_string(i));
+    for (int j = 0; j < leaves; ++j) {
+      auto leaf = node->add_leaves();
+      leaf->set_id(j);
+      leaf->set_label("leaf");
+    }
+  }
+  return result;
+}
+
+template <typename CbT>
+void run_echo(benchmark::State& state, CbT cb) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("bench_arena.TreeService");
+  service.add_method(bench_arena::TreeService::kTreeService_Echo_name,
+                     std::move(cb));
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench_arena::TreeService::Stub stub(&channel);
+
+  auto req = make_tree(state.range(0), 16);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(stub.Echo(req).get());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+}  // namespace
+
+static void BM_heap_messages(benchmark::State& state) {
+  run_echo(state, [](bench_arena::Tree req) {
+    bench_arena::Tree rep;
+    rep.CopyFrom(req);
+    return rep;
+  });
+}
+
+static void BM_arena_messages(benchmark::State& state) {
+  run_echo(state, [](const bench_arena::Tree& req, bench_arena::Tree& rep) {
+    rep.CopyFrom(req);
+  });
+}
+
+BENCHMARK(BM_heap_messages)->Arg(8)->Arg(64)->Arg(256)->UseRealTime();
+BENCHMARK(BM_arena_messages)->Arg(8)->Arg(64)->Arg(256)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,275 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A single stream downloading 16MB over a link with an emulated
+// round trip time. Arg 0 is the HTTP/2 stream window in KB, with BDP probing
+// off so that it stays put, or 0 for grpc's defaults (BDP probing on). Arg 1
+// is the round trip time in ms. Only one window's worth of data can be in
+// flight per round trip.
+//
+// The connection has a flow-control window of its own, which only grows
+// through BDP probing. With probing off, raising the stream window alone
+// leaves a long link stuck at 64KB per round trip.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// 16MB in chunks, as a file download would be sent.
+constexpr int message_count = 1024;
+constexpr std::size_t message_size = 16 << 10;
+
+using Clock = std::chrono::steady_clock;
+
+class Download_impl {
+ public:
+  using service_type = bench::DownloadService;
+
+  void Download(bench::Payload req, rpc::Stream_writer<bench::Payload> rep) {
+    auto msg = std::make_shared<bench::Payload>();
+    msg->set_data(req.data());
+    pump(std::move(rep), std::move(msg), req.work());
+  }
+
+ private:
+  static void pump(rpc::Stream_writer<bench::Payload> rep,
+                   std::shared_ptr<bench::Payload> msg, std::uint32_t left) {
+    rep.ready().finally([rep, msg, left](rpc::expected<void> ok) mutable {
+      if (!ok.has_value()) {
+        return;
+      }
+      if (left == 0) {
+        rep.complete();
+        return;
+      }
+      rep.push(*msg);
+      pump(std::move(rep), std::move(msg), left - 1);
+    });
+  }
+};
+// Forwards connections made to port() to target_port, holding every chunk of
+// data for half the round trip time in each direction. Bandwidth is not
+// limited.
+class Delay_proxy {
+ public:
+  Delay_proxy(int target_port, std::chrono::milliseconds rtt)
+      : target_port_(target_port), delay_(rtt / 2) {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    auto addr = loopback(0);
+    ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::listen(listen_fd_, 16);
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    acceptor_ = std::thread([this]() { accept_loop(); });
+  }
+
+  ~Delay_proxy() {
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    ::close(listen_fd_);
+    acceptor_.join();
+
+    std::lock_guard l(mtx_);
+    for (auto fd : fds_) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+    for (auto& t : threads_) {
+      t.join();
+    }
+    for (auto fd : fds_) {
+      ::close(fd);
+    }
+  }
+
+  int port() const { return port_; }
+
+ private:
+  struct Chunk {
+    Clock::time_point due;
+    std::string data;  // Empty once the source is closed.
+  };
+
+  struct Pipe {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Chunk> chunks;
+  };
+
+  static sockaddr_in loopback(int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+  }
+
+  void accept_loop() {
+    while (true) {
+      int client = ::accept(listen_fd_, nullptr, nullptr);
+      if (client < 0) {
+        return;
+      }
+
+      int server = ::socket(AF_INET, SOCK_STREAM, 0);
+      auto addr = loopback(target_port_);
+      ::connect(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+      // Like grpc's own sockets, so that small frames are not held back.
+      int one = 1;
+      ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      ::setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      std::lock_guard l(mtx_);
+      fds_.push_back(client);
+      fds_.push_back(server);
+      for (auto [from, to] : {std::pair(client, server), std::pair(server, client)}) {
+        auto pipe = std::make_shared<Pipe>();
+        threads_.emplace_back([=]() { read_side(from, *pipe); });
+        threads_.emplace_back([=]() { write_side(to, *pipe); });
+      }
+    }
+  }
+
+  void read_side(int from, Pipe& pipe) {
+    std::vector<char> buffer(256 * 1024);
+    while (true) {
+      auto n = ::read(from, buffer.data(), buffer.size());
+      std::lock_guard l(pipe.mtx);
+      pipe.chunks.push_back(
+          {Clock::now() + delay_,
+           n > 0 ? std::string(buffer.data(), static_cast<std::size_t>(n))
+                 : std::string()});
+      pipe.cv.notify_one();
+      if (n <= 0) {
+        return;
+      }
+    }
+  }
+
+  static void write_side(int to, Pipe& pipe) {
+    while (true) {
+      Chunk chunk;
+      {
+        std::unique_lock l(pipe.mtx);
+        pipe.cv.wait(l, [&] { return !pipe.chunks.empty(); });
+        chunk = std::move(pipe.chunks.front());
+        pipe.chunks.pop_front();
+      }
+      std::this_thread::sleep_until(chunk.due);
+
+      if (chunk.data.empty()) {
+        ::shutdown(to, SHUT_WR);
+        return;
+      }
+      for (std::size_t sent = 0; sent < chunk.data.size();) {
+        auto w = ::send(to, chunk.data.data() + sent, chunk.data.size() - sent,
+                          MSG_NOSIGNAL);
+        if (w <= 0) {
+          break;
+        }
+        sent += static_cast<std::size_t>(w);
+      }
+    }
+  }
+
+  int target_port_;
+  Clock::duration delay_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::thread acceptor_;
+
+  std::mutex mtx_;
+  std::vector<int> fds_;
+  std::vector<std::thread> threads_;
+};
+}  // namespace
+
+static void BM_bulk_transfer(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Download_impl impl;
+
+  rpc::Channel_args args;
+  args.max_receive_message_size(-1);
+  if (state.range(0)) {
+    args.bdp_probe(false).stream_window_size(
+        static_cast<int>(state.range(0)) * 1024);
+  }
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(impl)
+          .add_channel_args(args)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  Delay_proxy proxy(server_port, std::chrono::milliseconds(state.range(1)));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(proxy.port()), &client_queue,
+      args);
+  bench::DownloadService::Stub stub(&channel);
+
+  bench::Payload req;
+  req.set_data(std::string(message_size, 'd'));
+  req.set_work(message_count);
+
+  for (auto _ : state) {
+    auto received = std::make_shared<std::atomic<int>>(0);
+    stub.Download(req)
+        .for_each([received](bench::Payload) { ++*received; })
+        .get();
+
+    if (received->load() != message_count) {
+      state.SkipWithError("stream ended early");
+      break;
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() * message_count * message_size);
+}
+
+BENCHMARK(BM_bulk_transfer)
+    ->ArgsProduct({{0, 64, 1024, 8192}, {0, 10}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
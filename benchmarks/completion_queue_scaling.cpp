@@ -0,0 +1,98 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unary throughput of a single server completion queue as a function of the
+// number of threads draining it.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int calls_per_iteration = 512;
+constexpr std::uint32_t work_per_call = 20000;
+
+std::uint64_t burn_cpu(std::uint32_t work) {
+  std::uint64_t v = 0;
+  for (std::uint32_t i = 0; i < work; ++i) {
+    v = v * 6364136223846793005ULL + i;
+  }
+  return v;
+}
+
+class Echo_impl {
+ public:
+  using service_type = bench::EchoService;
+
+  bench::Payload Echo(bench::Payload req) {
+    benchmark::DoNotOptimize(burn_cpu(req.work()));
+    return req;
+  }
+};
+}  // namespace
+
+static void BM_unary_qps(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue(state.range(0));
+  rpc::Completion_queue client_queue(4);
+
+  Echo_impl impl;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(bench::EchoService::get_config(impl))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::EchoService::Stub stub(&channel);
+
+  bench::Payload req;
+  req.set_work(work_per_call);
+
+  std::vector<rpc::Future<bench::Payload>> results;
+  results.reserve(calls_per_iteration);
+
+  for (auto _ : state) {
+    for (int i = 0; i < calls_per_iteration; ++i) {
+      results.emplace_back(stub.Echo(req));
+    }
+
+    for (auto& f : results) {
+      benchmark::DoNotOptimize(f.get());
+    }
+    results.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * calls_per_iteration);
+}
+
+BENCHMARK(BM_unary_qps)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,165 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Broadcasting the same update to many server-streaming subscribers, with
+// the update encoded once per stream or once per broadcast.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+template <typename MsgT>
+class Fanout_impl {
+ public:
+  using service_type = bench::FanoutService;
+
+  rpc::Stream_future<MsgT> Subscribe(bench::Payload) {
+    rpc::Stream_promise<MsgT> prom;
+    auto result = prom.get_future();
+
+    std::lock_guard l(mtx_);
+    subscribers_.push_back(std::move(prom));
+    return result;
+  }
+
+  std::size_t subscriber_count() {
+    std::lock_guard l(mtx_);
+    return subscribers_.size();
+  }
+
+  void broadcast(const bench::Update& update) {
+    std::lock_guard l(mtx_);
+    if constexpr (std::is_same_v<MsgT, bench::Update>) {
+      for (auto& s : subscribers_) {
+        s.push(update);
+      }
+    } else {
+      MsgT shared(update);
+      for (auto& s : subscribers_) {
+        s.push(shared);
+      }
+    }
+  }
+
+  void close() {
+    std::lock_guard l(mtx_);
+    for (auto& s : subscribers_) {
+      s.complete();
+    }
+    subscribers_.clear();
+  }
+
+ private:
+  std::mutex mtx_;
+  std::vector<rpc::Stream_promise<MsgT>> subscribers_;
+};
+
+bench::Update make_update() {
+  bench::Update result;
+  for (int i = 0; i < 256; ++i) {
+    result.add_values(i * 7919);
+  }
+  for (int i = 0; i < 32; ++i) {
+    result.add_tags("tag_" + std::to_string(i));
+  }
+  return result;
+}
+
+template <typename MsgT>
+void run_fanout(benchmark::State& state) {
+  const auto stream_count = static_cast<std::size_t>(state.range(0));
+
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Fanout_impl<MsgT> service;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(service)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::FanoutService::Stub stub(&channel);
+
+  std::atomic<std::size_t> received = 0;
+  std::vector<rpc::Future<void>> streams;
+  streams.reserve(stream_count);
+  for (std::size_t i = 0; i < stream_count; ++i) {
+    streams.push_back(stub.Subscribe({}).for_each(
+        [&](bench::Update) { ++received; }));
+  }
+
+  while (service.subscriber_count() < stream_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  auto update = make_update();
+  std::size_t expected = 0;
+
+  for (auto _ : state) {
+    service.broadcast(update);
+
+    expected += stream_count;
+    while (received.load() < expected) {
+      std::this_thread::yield();
+    }
+  }
+
+  service.close();
+  for (auto& s : streams) {
+    s.get();
+  }
+
+  state.SetItemsProcessed(state.iterations() * stream_count);
+}
+}  // namespace
+
+static void BM_fanout_per_stream_encoding(benchmark::State& state) {
+  run_fanout<bench::Update>(state);
+}
+
+static void BM_fanout_shared_encoding(benchmark::State& state) {
+  run_fanout<rpc::Serialized<bench::Update>>(state);
+}
+
+BENCHMARK(BM_fanout_per_stream_encoding)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_fanout_shared_encoding)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
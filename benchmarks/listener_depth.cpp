@@ -0,0 +1,82 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Time taken by a server to accept and answer a burst of concurrent unary
+// calls, as a function of how many calls are pre-requested per queue.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int burst_size = 1024;
+}  // namespace
+
+static void BM_unary_burst(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue(2);
+  rpc::Completion_queue client_queue(2);
+
+  rpc::server::Method_options options;
+  options.listener_depth = state.range(0);
+
+  rpc::server::Service_config service("bench.EchoService");
+  service.add_method(bench::EchoService::kEchoService_Echo_name,
+                     [](bench::Payload req) { return req; }, {}, options);
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::EchoService::Stub stub(&channel);
+
+  bench::Payload req;
+
+  std::vector<rpc::Future<bench::Payload>> results;
+  results.reserve(burst_size);
+
+  for (auto _ : state) {
+    for (int i = 0; i < burst_size; ++i) {
+      results.emplace_back(stub.Echo(req));
+    }
+
+    for (auto& f : results) {
+      benchmark::DoNotOptimize(f.get());
+    }
+    results.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * burst_size);
+}
+
+BENCHMARK(BM_unary_burst)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,167 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Calls spread over three replicas, one of which is four times slower than
+// the others, with each of the balancing policies. The offered load fits in
+// the replicas' combined capacity, but not if the slow one gets a third of it.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// Each replica serves backend_threads calls at a time, so about 400 calls per
+// second for the fast ones and 100 for the slow one.
+constexpr std::size_t backend_threads = 2;
+constexpr auto fast_service_time = std::chrono::milliseconds(5);
+constexpr auto slow_service_time = std::chrono::milliseconds(20);
+
+constexpr int offered_per_second = 600;
+constexpr auto run_time = std::chrono::seconds(2);
+
+using Clock = std::chrono::steady_clock;
+
+class Replica_impl {
+ public:
+  using service_type = bench::EchoService;
+
+  explicit Replica_impl(Clock::duration service_time)
+      : service_time_(service_time) {}
+
+  rpc::Future<bench::Payload> Echo(bench::Payload req) {
+    auto prom = std::make_shared<rpc::Promise<bench::Payload>>();
+    auto result = prom->get_future();
+
+    backend_.push([this, prom, req]() {
+      std::this_thread::sleep_for(service_time_);
+      prom->set_value(req);
+    });
+    return result;
+  }
+
+ private:
+  Clock::duration service_time_;
+  rpc::Worker_pool backend_{backend_threads, 1 << 16};
+};
+
+std::unique_ptr<rpc::client::Balancing_policy> make_policy(int index) {
+  switch (index) {
+    case 0:
+      return std::make_unique<rpc::client::Round_robin_policy>();
+    case 1:
+      return std::make_unique<rpc::client::Least_outstanding_policy>();
+    case 2:
+      return std::make_unique<rpc::client::Power_of_two_choices_policy>();
+    default:
+      return std::make_unique<rpc::client::Consistent_hash_policy>();
+  }
+}
+
+double percentile(std::vector<double>& samples, double p) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  auto idx = static_cast<std::size_t>(p * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+  return samples[idx];
+}
+}  // namespace
+
+// Arg: 0 round-robin, 1 least outstanding, 2 power of two choices,
+// 3 consistent hash on a per-call key.
+static void BM_load_balancing(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  std::vector<std::unique_ptr<Replica_impl>> impls;
+  impls.push_back(std::make_unique<Replica_impl>(slow_service_time));
+  impls.push_back(std::make_unique<Replica_impl>(fast_service_time));
+  impls.push_back(std::make_unique<Replica_impl>(fast_service_time));
+
+  std::vector<std::unique_ptr<rpc::server::Server>> servers;
+  std::vector<std::string> addresses;
+  for (auto& impl : impls) {
+    int server_port = 0;
+    servers.push_back(std::make_unique<rpc::server::Server>(
+        rpc::server::Config()
+            .add_default_listening_queues({&server_queue, &server_queue + 1})
+            .add_service(*impl)
+            .add_listening_port("127.0.0.1:0", {}, &server_port)));
+    addresses.push_back("127.0.0.1:" + std::to_string(server_port));
+  }
+
+  rpc::client::Balanced_channel channel(addresses, &client_queue,
+                                        make_policy(state.range(0)));
+  bench::EchoService::Stub stub(&channel);
+
+  bench::Payload req;
+
+  std::mutex mtx;
+  std::vector<double> latencies_ms;
+
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::seconds(1)) / offered_per_second;
+
+  for (auto _ : state) {
+    std::vector<rpc::Future<void>> results;
+
+    auto begin = Clock::now();
+    int key = 0;
+    for (auto next = begin; next < begin + run_time; next += interval) {
+      std::this_thread::sleep_until(next);
+
+      rpc::client::Call_options options;
+      options.balancing_key = std::to_string(key++);
+
+      auto start = Clock::now();
+      results.push_back(stub.Echo(req, options).then(
+          [&, start](bench::Payload) {
+            std::chrono::duration<double, std::milli> elapsed =
+                Clock::now() - start;
+            std::lock_guard l(mtx);
+            latencies_ms.push_back(elapsed.count());
+          }));
+    }
+
+    for (auto& r : results) {
+      r.get();
+    }
+  }
+
+  state.counters["p50_ms"] = percentile(latencies_ms, 0.50);
+  state.counters["p99_ms"] = percentile(latencies_ms, 0.99);
+}
+
+BENCHMARK(BM_load_balancing)
+    ->DenseRange(0, 3)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
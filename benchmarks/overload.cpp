@@ -0,0 +1,158 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Calls offered at twice the rate a backend can serve them. Arg 0 lets every
+// call in, Arg 1 puts an adaptive concurrency limit on the method. Latency is
+// only measured for calls that succeed.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// The backend serves backend_threads calls at a time, each taking
+// service_time, so about 800 calls per second.
+constexpr std::size_t backend_threads = 4;
+constexpr auto service_time = std::chrono::milliseconds(5);
+
+constexpr int offered_per_second = 1600;
+constexpr auto run_time = std::chrono::seconds(2);
+
+using Clock = std::chrono::steady_clock;
+
+class Backend_impl {
+ public:
+  using service_type = bench::EchoService;
+
+  rpc::Future<bench::Payload> Echo(bench::Payload req) {
+    auto prom = std::make_shared<rpc::Promise<bench::Payload>>();
+    auto result = prom->get_future();
+
+    backend_.push([prom, req]() {
+      std::this_thread::sleep_for(service_time);
+      prom->set_value(req);
+    });
+    return result;
+  }
+
+ private:
+  rpc::Worker_pool backend_{backend_threads, 1 << 16};
+};
+
+double percentile(std::vector<double>& samples, double p) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  auto idx = static_cast<std::size_t>(p * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+  return samples[idx];
+}
+}  // namespace
+
+static void BM_overload(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Backend_impl impl;
+
+  std::shared_ptr<rpc::server::Adaptive_concurrency_limit> limit;
+  auto service = bench::EchoService::get_config(impl);
+  if (state.range(0)) {
+    rpc::server::Adaptive_limit_options limit_options;
+    limit_options.latency_threshold = std::chrono::milliseconds(20);
+    limit = std::make_shared<rpc::server::Adaptive_concurrency_limit>(
+        limit_options);
+
+    rpc::server::Method_options options;
+    options.concurrency_limit = limit;
+    service.set_method_options(options);
+  }
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::EchoService::Stub stub(&channel);
+
+  bench::Payload req;
+
+  std::mutex mtx;
+  std::vector<double> latencies_ms;
+  std::atomic<int> shed = 0;
+
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::seconds(1)) / offered_per_second;
+
+  for (auto _ : state) {
+    std::vector<rpc::Future<void>> results;
+
+    auto begin = Clock::now();
+    for (auto next = begin; next < begin + run_time; next += interval) {
+      std::this_thread::sleep_until(next);
+
+      auto start = Clock::now();
+      results.push_back(stub.Echo(req).then_expect(
+          [&, start](rpc::expected<bench::Payload> rep) {
+            if (!rep.has_value()) {
+              ++shed;
+              return;
+            }
+            std::chrono::duration<double, std::milli> elapsed =
+                Clock::now() - start;
+            std::lock_guard l(mtx);
+            latencies_ms.push_back(elapsed.count());
+          }));
+    }
+
+    for (auto& r : results) {
+      r.get();
+    }
+  }
+
+  state.counters["ok"] = static_cast<double>(latencies_ms.size());
+  state.counters["shed"] = shed.load();
+  state.counters["p50_ms"] = percentile(latencies_ms, 0.50);
+  state.counters["p99_ms"] = percentile(latencies_ms, 0.99);
+  if (limit) {
+    state.counters["limit"] = static_cast<double>(limit->limit());
+  }
+}
+
+BENCHMARK(BM_overload)
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,133 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cost of moving protobuf messages in and out of grpc byte buffers, as a
+// function of the message size.
+
+#include "easy_grpc/easy_grpc.h"
+#include "easy_grpc/ext_protobuf/serialize.h"
+
+#include "generated/benchmark.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// Incoming messages are split in slices about this big by the transport.
+constexpr std::size_t wire_slice_size = 16 * 1024;
+
+grpc_byte_buffer* make_wire_buffer(std::size_t payload_size) {
+  bench::Payload msg;
+  msg.set_data(std::string(payload_size, 'x'));
+
+  std::string raw;
+  msg.SerializeToString(&raw);
+
+  std::vector<grpc_slice> slices;
+  for (std::size_t i = 0; i < raw.size(); i += wire_slice_size) {
+    auto len = std::min(wire_slice_size, raw.size() - i);
+    slices.push_back(grpc_slice_from_copied_buffer(raw.data() + i, len));
+  }
+
+  auto result = grpc_raw_byte_buffer_create(slices.data(), slices.size());
+  for (auto& s : slices) {
+    grpc_slice_unref(s);
+  }
+  return result;
+}
+
+// What deserialization used to do: flatten the buffer, then parse.
+bench::Payload readall_deserialize(grpc_byte_buffer* data) {
+  grpc_byte_buffer_reader reader;
+  grpc_byte_buffer_reader_init(&reader, data);
+  auto slice = grpc_byte_buffer_reader_readall(&reader);
+
+  bench::Payload result;
+  result.ParseFromArray(GRPC_SLICE_START_PTR(slice), GRPC_SLICE_LENGTH(slice));
+
+  grpc_slice_unref(slice);
+  grpc_byte_buffer_reader_destroy(&reader);
+  return result;
+}
+
+// What serialization used to do: a single slice sized for the whole message.
+grpc_byte_buffer* single_slice_serialize(const bench::Payload& msg) {
+  auto slice = grpc_slice_malloc(msg.ByteSizeLong());
+  msg.SerializeWithCachedSizesToArray(GRPC_SLICE_START_PTR(slice));
+
+  auto result = grpc_raw_byte_buffer_create(&slice, 1);
+  grpc_slice_unref(slice);
+  return result;
+}
+}  // namespace
+
+static void BM_deserialize_readall(benchmark::State& state) {
+  rpc::Environment env;
+  auto buffer = make_wire_buffer(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(readall_deserialize(buffer));
+  }
+
+  grpc_byte_buffer_destroy(buffer);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_deserialize_zero_copy(benchmark::State& state) {
+  rpc::Environment env;
+  auto buffer = make_wire_buffer(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rpc::deserialize<bench::Payload>(buffer));
+  }
+
+  grpc_byte_buffer_destroy(buffer);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_serialize_single_slice(benchmark::State& state) {
+  rpc::Environment env;
+  bench::Payload msg;
+  msg.set_data(std::string(state.range(0), 'x'));
+
+  for (auto _ : state) {
+    grpc_byte_buffer_destroy(single_slice_serialize(msg));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_serialize_slice_chain(benchmark::State& state) {
+  rpc::Environment env;
+  bench::Payload msg;
+  msg.set_data(std::string(state.range(0), 'x'));
+
+  for (auto _ : state) {
+    grpc_byte_buffer_destroy(rpc::serialize(msg));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_deserialize_readall)->Range(1 << 10, 8 << 20);
+BENCHMARK(BM_deserialize_zero_copy)->Range(1 << 10, 8 << 20);
+BENCHMARK(BM_serialize_single_slice)->Range(1 << 10, 8 << 20);
+BENCHMARK(BM_serialize_slice_chain)->Range(1 << 10, 8 << 20);
+
+BENCHMARK_MAIN();
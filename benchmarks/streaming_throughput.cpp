@@ -0,0 +1,132 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Small messages streamed back to back from the server, with every message
+// flushed on its own, or with queued messages coalesced into fewer writes.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int message_count = 10000;
+
+class Download_impl {
+ public:
+  using service_type = bench::DownloadService;
+
+  void Download(bench::Payload req, rpc::Stream_writer<bench::Payload> rep) {
+    auto msg = std::make_shared<bench::Payload>();
+    msg->set_data(req.data());
+    pump(std::move(rep), std::move(msg), req.work());
+  }
+
+ private:
+  // Pushes as long as the writer has room, and resumes once it has some
+  // again.
+  static void pump(rpc::Stream_writer<bench::Payload> rep,
+                   std::shared_ptr<bench::Payload> msg, std::uint32_t left) {
+    rep.ready().finally([rep, msg, left](rpc::expected<void> ok) mutable {
+      if (!ok.has_value()) {
+        return;
+      }
+      if (left == 0) {
+        rep.complete();
+        return;
+      }
+      rep.push(*msg);
+      pump(std::move(rep), std::move(msg), left - 1);
+    });
+  }
+};
+
+void run_download(benchmark::State& state, bool coalesce) {
+  const auto message_size = static_cast<std::size_t>(state.range(0));
+
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Download_impl impl;
+
+  rpc::server::Method_options options;
+  options.stream_capacity = 64;
+  options.coalesce_writes = coalesce;
+
+  auto service = bench::DownloadService::get_config(impl);
+  service.set_method_options(options);
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::DownloadService::Stub stub(&channel);
+
+  bench::Payload req;
+  req.set_data(std::string(message_size, 'd'));
+  req.set_work(message_count);
+
+  for (auto _ : state) {
+    auto received = std::make_shared<std::atomic<int>>(0);
+    stub.Download(req)
+        .for_each([received](bench::Payload) { ++*received; })
+        .get();
+
+    if (received->load() != message_count) {
+      state.SkipWithError("stream ended early");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * message_count);
+  state.SetBytesProcessed(state.iterations() * message_count * message_size);
+}
+}  // namespace
+
+static void BM_download_flushed(benchmark::State& state) {
+  run_download(state, false);
+}
+
+static void BM_download_coalesced(benchmark::State& state) {
+  run_download(state, true);
+}
+
+BENCHMARK(BM_download_flushed)
+    ->Arg(16)
+    ->Arg(256)
+    ->Arg(4096)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_download_coalesced)
+    ->Arg(16)
+    ->Arg(256)
+    ->Arg(4096)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
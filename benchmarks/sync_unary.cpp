@@ -0,0 +1,86 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Latency of back to back unary calls from a single caller that blocks on
+// each reply, through the Future returned by the stub and through
+// call_sync(), which waits on the caller's own pluck queue.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+namespace rpc = easy_grpc;
+
+namespace {
+class Echo_impl {
+ public:
+  using service_type = bench::EchoService;
+
+  bench::Payload Echo(bench::Payload req) { return req; }
+};
+
+struct Fixture {
+  Fixture() {
+    server = std::make_unique<rpc::server::Server>(
+        rpc::server::Config()
+            .add_default_listening_queues({&server_queue, &server_queue + 1})
+            .add_service(impl)
+            .add_listening_port("127.0.0.1:0", {}, &server_port));
+    channel = std::make_unique<rpc::client::Unsecure_channel>(
+        std::string("127.0.0.1:") + std::to_string(server_port),
+        &client_queue);
+    stub = std::make_unique<bench::EchoService::Stub>(channel.get());
+  }
+
+  rpc::Environment env;
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Echo_impl impl;
+  int server_port = 0;
+  std::unique_ptr<rpc::server::Server> server;
+  std::unique_ptr<rpc::client::Unsecure_channel> channel;
+  std::unique_ptr<bench::EchoService::Stub> stub;
+};
+}  // namespace
+
+static void BM_unary_future_get(benchmark::State& state) {
+  Fixture fixture;
+  bench::Payload req;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fixture.stub->Echo(req).get());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_unary_call_sync(benchmark::State& state) {
+  Fixture fixture;
+  bench::Payload req;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fixture.stub->Echo_sync(req));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_unary_future_get)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_unary_call_sync)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
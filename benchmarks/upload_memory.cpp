@@ -0,0 +1,142 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Client memory while uploading a large client stream to a server that reads
+// it slowly, with the producer either pushing everything up front or waiting
+// on the writer's ready() before each push. Linux only, as the resident set
+// size is read from /proc.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int message_count = 10000;
+constexpr std::size_t message_size = 4096;
+
+class Throttled_upload_impl {
+ public:
+  using service_type = bench::UploadService;
+
+  rpc::Future<bench::Payload> Upload(rpc::Stream_future<bench::Payload> reqs) {
+    auto count = std::make_shared<std::uint32_t>(0);
+    return reqs
+        .for_each([count](bench::Payload) {
+          std::this_thread::sleep_for(std::chrono::microseconds(20));
+          ++*count;
+        })
+        .then([count]() {
+          bench::Payload result;
+          result.set_work(*count);
+          return result;
+        });
+  }
+};
+
+std::size_t resident_bytes() {
+  std::size_t total = 0;
+  std::size_t resident = 0;
+  std::ifstream("/proc/self/statm") >> total >> resident;
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+template <bool wait_for_ready>
+void run_upload(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Throttled_upload_impl service;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(service)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::UploadService::Stub stub(&channel);
+
+  bench::Payload req;
+  req.set_data(std::string(message_size, 'u'));
+
+  std::size_t peak_growth = 0;
+
+  for (auto _ : state) {
+    malloc_trim(0);
+    auto baseline = resident_bytes();
+
+    std::atomic<bool> done = false;
+    std::size_t peak = baseline;
+    std::thread sampler([&] {
+      while (!done) {
+        peak = std::max(peak, resident_bytes());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+    auto [writer, result] = stub.Upload(rpc::client::with_writer);
+    for (int i = 0; i < message_count; ++i) {
+      if constexpr (wait_for_ready) {
+        writer.ready().get();
+      }
+      writer.push(req);
+    }
+    writer.complete();
+
+    benchmark::DoNotOptimize(result.get());
+
+    done = true;
+    sampler.join();
+    peak_growth = std::max(peak_growth, peak - baseline);
+  }
+
+  state.counters["peak_rss_growth_mb"] =
+      static_cast<double>(peak_growth) / (1024 * 1024);
+  state.SetBytesProcessed(state.iterations() * message_count * message_size);
+}
+}  // namespace
+
+static void BM_upload_wait_for_ready(benchmark::State& state) {
+  run_upload<true>(state);
+}
+
+static void BM_upload_push_everything(benchmark::State& state) {
+  run_upload<false>(state);
+}
+
+// The bounded run goes first, the allocator does not always give memory back.
+BENCHMARK(BM_upload_wait_for_ready)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_upload_push_everything)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
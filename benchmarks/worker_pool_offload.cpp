@@ -0,0 +1,128 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Latency of a fast method sharing its completion queue with a slow,
+// blocking, synchronous method. Arg 0 runs the slow handler inline, Arg 1
+// offloads it to a worker pool.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int slow_calls_per_iteration = 8;
+constexpr int fast_calls_per_iteration = 64;
+constexpr auto slow_call_duration = std::chrono::milliseconds(2);
+
+using Clock = std::chrono::steady_clock;
+
+class Mixed_impl {
+ public:
+  using service_type = bench::MixedService;
+
+  bench::Payload Slow(bench::Payload req) {
+    std::this_thread::sleep_for(slow_call_duration);
+    return req;
+  }
+
+  bench::Payload Fast(bench::Payload req) { return req; }
+};
+
+double percentile(std::vector<double>& samples, double p) {
+  auto idx = static_cast<std::size_t>(p * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+  return samples[idx];
+}
+}  // namespace
+
+static void BM_fast_latency(benchmark::State& state) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Mixed_impl impl;
+
+  auto service = bench::MixedService::get_config(impl);
+  if (state.range(0)) {
+    rpc::server::Method_options options;
+    options.worker_pool = std::make_shared<rpc::Worker_pool>(4);
+    service.set_method_options(bench::MixedService::kMixedService_Slow_name,
+                               options);
+  }
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::MixedService::Stub stub(&channel);
+
+  bench::Payload req;
+
+  std::mutex mtx;
+  std::vector<double> latencies_us;
+
+  std::vector<rpc::Future<bench::Payload>> slow_results;
+  std::vector<rpc::Future<void>> fast_results;
+
+  for (auto _ : state) {
+    for (int i = 0; i < slow_calls_per_iteration; ++i) {
+      slow_results.emplace_back(stub.Slow(req));
+    }
+
+    for (int i = 0; i < fast_calls_per_iteration; ++i) {
+      auto start = Clock::now();
+      fast_results.emplace_back(stub.Fast(req).then([&, start](bench::Payload) {
+        std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+        std::lock_guard l(mtx);
+        latencies_us.push_back(elapsed.count());
+      }));
+    }
+
+    for (auto& f : fast_results) {
+      f.get();
+    }
+    for (auto& f : slow_results) {
+      f.get();
+    }
+    fast_results.clear();
+    slow_results.clear();
+  }
+
+  state.counters["fast_p50_us"] = percentile(latencies_us, 0.50);
+  state.counters["fast_p99_us"] = percentile(latencies_us, 0.99);
+}
+
+BENCHMARK(BM_fast_latency)
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Several producer threads feeding the same client-streaming call, racing
+// each other and the completion queue thread on the stream's send queue.
+
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/benchmark.egrpc.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+constexpr int message_count = 40000;
+
+class Counting_upload_impl {
+ public:
+  using service_type = bench::UploadService;
+
+  rpc::Future<bench::Payload> Upload(rpc::Stream_future<bench::Payload> reqs) {
+    auto count = std::make_shared<std::uint32_t>(0);
+    return reqs.for_each([count](bench::Payload) { ++*count; })
+        .then([count]() {
+          bench::Payload result;
+          result.set_work(*count);
+          return result;
+        });
+  }
+};
+}  // namespace
+
+static void BM_concurrent_producers(benchmark::State& state) {
+  const auto producer_count = static_cast<int>(state.range(0));
+  const int per_producer = message_count / producer_count;
+
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Counting_upload_impl impl;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(impl)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  bench::UploadService::Stub stub(&channel);
+
+  rpc::client::Call_options options;
+  options.stream_capacity = 256;
+
+  bench::Payload msg;
+  msg.set_data(std::string(64, 'c'));
+
+  for (auto _ : state) {
+    auto [writer, result] = stub.Upload(rpc::client::with_writer, options);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producer_count; ++p) {
+      producers.emplace_back([&msg, per_producer, writer = writer]() mutable {
+        for (int i = 0; i < per_producer; ++i) {
+          writer.ready().get();
+          writer.push(msg);
+        }
+      });
+    }
+
+    for (auto& p : producers) {
+      p.join();
+    }
+    writer.complete();
+
+    auto received = result.get().work();
+    if (received != static_cast<std::uint32_t>(per_producer * producer_count)) {
+      state.SkipWithError("messages were lost");
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * per_producer * producer_count);
+}
+
+BENCHMARK(BM_concurrent_producers)
+    ->Arg(1)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
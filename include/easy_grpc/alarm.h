@@ -0,0 +1,63 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_ALARM_INCLUDED_H
+#define EASY_GRPC_ALARM_INCLUDED_H
+
+#include "easy_grpc/completion_queue.h"
+
+#include "grpc/grpc.h"
+#include "grpc/support/time.h"
+
+#include <atomic>
+
+namespace easy_grpc {
+
+namespace detail {
+// Sets off every pending alarm of queue, or of every queue if it is null.
+// Invoked by ~Completion_queue() and ~Environment().
+void cancel_alarms(Completion_queue* queue = nullptr);
+}  // namespace detail
+
+// Delivers tag to queue once deadline has passed, without a thread of its own.
+//
+// An alarm goes off early when it is cancelled, or when its queue or the
+// Environment is destroyed. Whoever receives the tag tells the two apart with
+// cancelled(). Destroying an alarm that did not go off yet also sets it off,
+// so its owner keeps it until the tag comes in.
+class Alarm {
+ public:
+  Alarm(Completion_queue* queue, gpr_timespec deadline, Completion_tag tag);
+  ~Alarm();
+
+  Alarm(const Alarm&) = delete;
+  Alarm& operator=(const Alarm&) = delete;
+
+  // Sets the alarm off right away. Does nothing once it went off.
+  void cancel();
+
+  bool cancelled() const { return cancelled_; }
+
+ private:
+  friend void detail::cancel_alarms(Completion_queue* queue);
+
+  void cancel_();
+
+  Completion_queue* queue_;
+  grpc_channel* channel_;
+  std::atomic<bool> cancelled_ = false;
+};
+
+}  // namespace easy_grpc
+#endif
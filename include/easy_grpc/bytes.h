@@ -0,0 +1,161 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_BYTES_INCLUDED_H
+#define EASY_GRPC_BYTES_INCLUDED_H
+
+#include "easy_grpc/serialize.h"
+
+#include "grpc/slice.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace easy_grpc {
+
+namespace detail {
+// Below this, copying the bytes is cheaper than keeping the container
+// alive on the heap.
+constexpr std::size_t min_adopted_size = 256;
+
+// Moves the container behind a slice, without copying its content.
+template <typename ContainerT>
+grpc_slice adopt_container(ContainerT&& data) {
+  if (data.size() < min_adopted_size) {
+    return grpc_slice_from_copied_buffer(
+        reinterpret_cast<const char*>(data.data()), data.size());
+  }
+
+  auto owned = new ContainerT(std::move(data));
+  return grpc_slice_new_with_user_data(
+      owned->data(), owned->size(),
+      [](void* p) { delete static_cast<ContainerT*>(p); }, owned);
+}
+
+// Takes over the caller's reference to slice.
+inline grpc_byte_buffer* buffer_from_slice(grpc_slice slice) {
+  auto result = grpc_raw_byte_buffer_create(&slice, 1);
+  grpc_slice_unref(slice);
+  return result;
+}
+
+// A reference to the buffer's content. Only copies if the content is
+// spread over multiple slices.
+inline grpc_slice slice_from_buffer(grpc_byte_buffer* data) {
+  if (data->type == GRPC_BB_RAW &&
+      data->data.raw.compression == GRPC_COMPRESS_NONE &&
+      data->data.raw.slice_buffer.count == 1) {
+    return grpc_slice_ref(data->data.raw.slice_buffer.slices[0]);
+  }
+
+  grpc_byte_buffer_reader reader;
+  grpc_byte_buffer_reader_init(&reader, data);
+  auto result = grpc_byte_buffer_reader_readall(&reader);
+  grpc_byte_buffer_reader_destroy(&reader);
+  return result;
+}
+}  // namespace detail
+
+// Raw bytes held by a grpc slice. Copies share the same slice.
+//
+// Used as a message type, it is received without copying the payload, and
+// sent without copying it either.
+class Byte_slice {
+ public:
+  Byte_slice() : slice_(grpc_empty_slice()) {}
+
+  // Takes ownership of the container's storage.
+  explicit Byte_slice(std::string data)
+      : slice_(detail::adopt_container(std::move(data))) {}
+  explicit Byte_slice(std::vector<std::uint8_t> data)
+      : slice_(detail::adopt_container(std::move(data))) {}
+
+  Byte_slice(const Byte_slice& rhs) : slice_(grpc_slice_ref(rhs.slice_)) {}
+  Byte_slice(Byte_slice&& rhs) : slice_(rhs.slice_) {
+    rhs.slice_ = grpc_empty_slice();
+  }
+
+  Byte_slice& operator=(Byte_slice rhs) {
+    std::swap(slice_, rhs.slice_);
+    return *this;
+  }
+
+  ~Byte_slice() { grpc_slice_unref(slice_); }
+
+  // Takes over the caller's reference to slice.
+  static Byte_slice adopt(grpc_slice slice) {
+    Byte_slice result;
+    result.slice_ = slice;
+    return result;
+  }
+
+  const char* data() const {
+    return reinterpret_cast<const char*>(GRPC_SLICE_START_PTR(slice_));
+  }
+  std::size_t size() const { return GRPC_SLICE_LENGTH(slice_); }
+  bool empty() const { return size() == 0; }
+
+  std::string_view view() const { return {data(), size()}; }
+
+  const grpc_slice& slice() const { return slice_; }
+
+ private:
+  grpc_slice slice_;
+};
+
+template <>
+struct Serializer<Byte_slice> {
+  static grpc_byte_buffer* serialize(const Byte_slice& data) {
+    return detail::buffer_from_slice(grpc_slice_ref(data.slice()));
+  }
+
+  static Byte_slice deserialize(grpc_byte_buffer* data) {
+    return Byte_slice::adopt(detail::slice_from_buffer(data));
+  }
+};
+
+// Owning byte containers are moved into the outgoing slice when sent as
+// rvalues, and copied otherwise.
+template <typename ContainerT>
+struct Byte_container_serializer {
+  static grpc_byte_buffer* serialize(const ContainerT& data) {
+    return detail::buffer_from_slice(grpc_slice_from_copied_buffer(
+        reinterpret_cast<const char*>(data.data()), data.size()));
+  }
+
+  static grpc_byte_buffer* serialize(ContainerT&& data) {
+    return detail::buffer_from_slice(detail::adopt_container(std::move(data)));
+  }
+
+  static ContainerT deserialize(grpc_byte_buffer* data) {
+    auto slice = detail::slice_from_buffer(data);
+    auto begin = GRPC_SLICE_START_PTR(slice);
+    ContainerT result(begin, begin + GRPC_SLICE_LENGTH(slice));
+    grpc_slice_unref(slice);
+    return result;
+  }
+};
+
+template <>
+struct Serializer<std::string> : public Byte_container_serializer<std::string> {};
+
+template <>
+struct Serializer<std::vector<std::uint8_t>>
+    : public Byte_container_serializer<std::vector<std::uint8_t>> {};
+}  // namespace easy_grpc
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CHANNEL_ARGS_H_INCLUDED
+#define EASY_GRPC_CHANNEL_ARGS_H_INCLUDED
+
+#include "easy_grpc/compression.h"
+
+#include "grpc/grpc.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace easy_grpc {
+
+// Transport settings of a channel or server, handed to grpc when it is
+// created. Setting the same argument twice keeps the last value.
+//
+// Sizes are in bytes. Anything not covered by a dedicated setter can be
+// passed through set(), using grpc's GRPC_ARG_* keys.
+class Channel_args {
+ public:
+  using Value = std::variant<int, std::string>;
+
+  // Largest message that will be accepted/sent. -1 means unlimited. grpc
+  // defaults to 4MB on receive and unlimited on send.
+  Channel_args& max_receive_message_size(int size);
+  Channel_args& max_send_message_size(int size);
+
+  // How much data a stream may have in flight before the peer has to
+  // acknowledge it (the HTTP/2 flow-control window). With BDP probing on, this
+  // is only a starting point.
+  Channel_args& stream_window_size(int size);
+
+  // Lets grpc grow the stream and connection flow-control windows as it
+  // measures the link's bandwidth-delay product. On by default, and the only
+  // way for the connection's window to grow past 64KB.
+  Channel_args& bdp_probe(bool enabled);
+
+  // How much grpc buffers before writing to the socket, and the largest HTTP/2
+  // frame it accepts.
+  Channel_args& write_buffer_size(int size);
+  Channel_args& max_frame_size(int size);
+
+  // Pings the peer after time without activity, and drops the connection if
+  // the ping is not acknowledged within timeout. Without permit_without_calls,
+  // idle connections are not pinged.
+  Channel_args& keepalive(std::chrono::milliseconds time,
+                          std::chrono::milliseconds timeout,
+                          bool permit_without_calls = false);
+
+  // Servers only: streams a single client connection may have open at once.
+  Channel_args& max_concurrent_streams(int count);
+
+  // Default compression, see Compression_options.
+  Channel_args& compression(const Compression_options& options);
+
+  Channel_args& set(std::string key, int value);
+  Channel_args& set(std::string key, std::string value);
+
+  // Copies every argument of other over this one.
+  Channel_args& merge(const Channel_args& other);
+
+  const Value* find(const std::string& key) const;
+  bool empty() const { return values_.empty(); }
+
+  // grpc's view of the arguments. It points into this object, and is only
+  // valid as long as it is neither modified nor destroyed.
+  std::vector<grpc_arg> to_grpc() const;
+
+ private:
+  std::map<std::string, Value> values_;
+};
+
+}  // namespace easy_grpc
+#endif
@@ -0,0 +1,89 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_BALANCED_CHANNEL_INCLUDED_H
+#define EASY_GRPC_CLIENT_BALANCED_CHANNEL_INCLUDED_H
+
+#include "easy_grpc/channel_args.h"
+#include "easy_grpc/client/balancing_policy.h"
+#include "easy_grpc/client/channel.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace easy_grpc {
+namespace client {
+
+// Spreads calls over several endpoints, each reached through its own grpc
+// channel. Every call goes to a single endpoint for its whole lifetime, chosen
+// by the policy when the call is created.
+class Balanced_channel : public Channel {
+ public:
+  // Round-robin if policy is null.
+  Balanced_channel(const std::vector<std::string>& addresses,
+                   Completion_queue* default_pool,
+                   std::unique_ptr<Balancing_policy> policy = nullptr,
+                   const Channel_args& args = {});
+
+  ~Balanced_channel();
+
+  using Channel::create_call;
+
+  void* register_method(const char* name) override;
+  Channel_call create_call(void* method_tag, const Call_options& options,
+                           grpc_completion_queue* queue,
+                           std::size_t exclude) override;
+
+  std::size_t size() const { return endpoints_.size(); }
+  const std::string& address(std::size_t index) const;
+
+  // Calls currently in flight on the endpoint at index.
+  std::size_t in_flight(std::size_t index) const;
+
+  struct Endpoint_config {
+    std::string address;
+    Channel_args args;
+  };
+
+ protected:
+  Balanced_channel(const std::vector<Endpoint_config>& endpoints,
+                   Completion_queue* default_pool,
+                   std::unique_ptr<Balancing_policy> policy);
+
+ private:
+  struct Endpoint {
+    std::string address;
+    grpc_channel* handle;
+    In_flight_token::Counter in_flight;
+  };
+
+  std::vector<Endpoint> endpoints_;
+  std::unique_ptr<Balancing_policy> policy_;
+
+  // One tag per endpoint for each registered method.
+  std::mutex methods_mtx_;
+  std::deque<std::vector<void*>> methods_;
+};
+
+// Splits a comma-separated list of addresses, like
+// "10.0.0.1:50051,10.0.0.2:50051".
+std::vector<std::string> parse_address_list(const std::string& list);
+
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -0,0 +1,103 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_BALANCING_POLICY_INCLUDED_H
+#define EASY_GRPC_CLIENT_BALANCING_POLICY_INCLUDED_H
+
+#include "easy_grpc/client/call_options.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace easy_grpc {
+namespace client {
+
+class Balanced_channel;
+
+// Decides which endpoint of a Balanced_channel each call goes to. A policy
+// belongs to a single channel, and pick() can be called from many threads at
+// once.
+class Balancing_policy {
+ public:
+  virtual ~Balancing_policy() {}
+
+  // Invoked once the channel's endpoints are set up, before any pick().
+  virtual void init(const Balanced_channel&) {}
+
+  // Index of the endpoint a call made with options goes to. That's never
+  // exclude, unless the channel has a single endpoint. exclude is
+  // Channel::no_endpoint when any endpoint will do.
+  virtual std::size_t pick(const Balanced_channel& channel,
+                           const Call_options& options,
+                           std::size_t exclude) = 0;
+};
+
+class Round_robin_policy : public Balancing_policy {
+ public:
+  std::size_t pick(const Balanced_channel& channel,
+                   const Call_options& options,
+                   std::size_t exclude) override;
+
+ private:
+  std::atomic<std::size_t> next_ = 0;
+};
+
+// The endpoint with the fewest calls in flight. Ties go round-robin, so that
+// an idle channel still uses every endpoint.
+class Least_outstanding_policy : public Balancing_policy {
+ public:
+  std::size_t pick(const Balanced_channel& channel,
+                   const Call_options& options,
+                   std::size_t exclude) override;
+
+ private:
+  std::atomic<std::size_t> next_ = 0;
+};
+
+// The endpoint with the fewest calls in flight among two picked at random.
+// Nearly as good as looking at every endpoint, at a constant cost, and
+// without every client piling onto the same least loaded one.
+class Power_of_two_choices_policy : public Balancing_policy {
+ public:
+  std::size_t pick(const Balanced_channel& channel,
+                   const Call_options& options,
+                   std::size_t exclude) override;
+};
+
+// Sends calls with the same Call_options::balancing_key to the same endpoint,
+// and keeps most keys in place when endpoints are added or removed. Calls
+// without a key go round-robin.
+class Consistent_hash_policy : public Balancing_policy {
+ public:
+  // Each endpoint is put on the hash ring this many times, which evens out the
+  // share of keys each one gets.
+  explicit Consistent_hash_policy(std::size_t replicas = 100);
+
+  void init(const Balanced_channel& channel) override;
+  std::size_t pick(const Balanced_channel& channel,
+                   const Call_options& options,
+                   std::size_t exclude) override;
+
+ private:
+  std::size_t replicas_;
+  std::vector<std::pair<std::uint64_t, std::size_t>> ring_;
+  std::atomic<std::size_t> next_ = 0;
+};
+
+}  // namespace client
+}  // namespace easy_grpc
+#endif
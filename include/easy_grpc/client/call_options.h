@@ -0,0 +1,71 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_CALL_OPTIONS_INCLUDED_H
+#define EASY_GRPC_CLIENT_CALL_OPTIONS_INCLUDED_H
+
+#include "easy_grpc/client/hedging.h"
+#include "easy_grpc/client/retry_policy.h"
+
+#include "grpc/compression.h"
+#include "grpc/grpc.h"
+#include "grpc/support/time.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace easy_grpc {
+
+class Completion_queue;
+
+namespace client {
+struct Call_options {
+  Completion_queue* completion_queue = nullptr;
+  gpr_timespec deadline = gpr_inf_future(GPR_CLOCK_REALTIME);
+
+  // How many requests the Stream_writer of a client-streaming or bidir call
+  // made with with_writer holds before ready() stops resolving immediately.
+  std::size_t stream_capacity = 16;
+
+  // Lets grpc batch requests that are queued back to back into fewer frames
+  // and syscalls, instead of flushing each of them on its own.
+  bool coalesce_writes = false;
+
+  // Compresses the call's requests with this algorithm instead of the
+  // channel's default. GRPC_COMPRESS_NONE turns compression off.
+  std::optional<grpc_compression_algorithm> compression;
+
+  // Calls with the same key go to the same endpoint of a Balanced_channel
+  // that uses a Consistent_hash_policy.
+  std::string balancing_key;
+
+  // Sends a second copy of a unary call that is slow to get a reply. Hedges
+  // go through the same channel, and a Balanced_channel or Channel_pool sends
+  // them to another endpoint than the first copy.
+  std::shared_ptr<Hedging_policy> hedging;
+
+  // Sends a unary call again when it fails with one of the policy's
+  // retryable codes. Hedged calls are not retried.
+  std::shared_ptr<const Retry_policy> retry;
+};
+
+// Passed first to a client-streaming or bidir stub method, gets a bounded
+// Stream_writer for the requests instead of a Stream_promise.
+struct With_writer {};
+inline constexpr With_writer with_writer{};
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -15,59 +15,193 @@
 #ifndef EASY_GRPC_CLIENT_CHANNEL_INCLUDED_H
 #define EASY_GRPC_CLIENT_CHANNEL_INCLUDED_H
 
+#include "easy_grpc/completion_queue.h"
+#include "easy_grpc/client/call_options.h"
+
 #include "grpc/grpc.h"
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace easy_grpc {
 
-class Completion_queue;
-
 namespace client {
+
+// Counts a call as in flight on whatever carries it, for as long as the token
+// is alive. Calls hold on to theirs until they are over.
+class In_flight_token {
+ public:
+  using Counter = std::shared_ptr<std::atomic<std::size_t>>;
+
+  In_flight_token() = default;
+  explicit In_flight_token(Counter counter) : counter_(std::move(counter)) {
+    ++*counter_;
+  }
+
+  In_flight_token(In_flight_token&&) = default;
+  In_flight_token& operator=(In_flight_token&& rhs) {
+    release();
+    counter_ = std::move(rhs.counter_);
+    return *this;
+  }
+
+  ~In_flight_token() { release(); }
+
+ private:
+  void release() {
+    if (counter_) {
+      --*counter_;
+      counter_.reset();
+    }
+  }
+
+  Counter counter_;
+};
+
+struct Channel_call {
+  grpc_call* call = nullptr;
+  In_flight_token in_flight;
+
+  // Which of the channel's endpoints the call goes to. Always 0 on a channel
+  // with a single endpoint.
+  std::size_t endpoint = 0;
+};
+
+class Channel;
+
+namespace detail {
+// Where a channel lives, for calls that keep creating attempts after the stub
+// handed them off, like hedged and retried ones. Channels empty theirs when
+// they go away, and can't do so while an attempt is being created.
+class Channel_anchor {
+ public:
+  explicit Channel_anchor(Channel* channel) : channel_(channel) {}
+
+  // Empty if the channel is gone.
+  std::optional<Channel_call> create_call(void* method_tag,
+                                          const Call_options& options,
+                                          std::size_t exclude);
+
+ private:
+  friend class client::Channel;
+
+  std::mutex mtx_;
+  Channel* channel_;
+};
+}  // namespace detail
+
 class Channel {
  public:
   Channel() = default;
 
   virtual ~Channel() {
+    retire();
     if (handle_) {
      grpc_channel_destroy(handle_);
     }
   }
 
-  void* register_method(const char* name) {
+  // Prepares the channel for calls to the method called name. The returned tag
+  // identifies the method in create_call().
+  virtual void* register_method(const char* name) {
     return grpc_channel_register_call(handle_, name, nullptr, nullptr); 
   }
 
+  // For create_call(), when any endpoint will do.
+  static constexpr std::size_t no_endpoint = std::size_t(-1);
+
+  // Creates a call to a registered method, on options' completion queue.
+  Channel_call create_call(void* method_tag, const Call_options& options,
+                           std::size_t exclude = no_endpoint) {
+    return create_call(method_tag, options, options.completion_queue->handle(),
+                       exclude);
+  }
+
+  // Creates a call to a registered method, on queue. Channels with several
+  // endpoints send it anywhere but to the endpoint at index exclude, unless
+  // that's the only one they have.
+  virtual Channel_call create_call(void* method_tag,
+                                   const Call_options& options,
+                                   grpc_completion_queue* queue,
+                                   std::size_t /*exclude*/) {
+    return {grpc_channel_create_registered_call(
+                handle_, nullptr, GRPC_PROPAGATE_DEFAULTS, queue, method_tag,
+                options.deadline, nullptr),
+            {}};
+  }
+
   Completion_queue* default_queue() const { return default_queue_; }
   grpc_channel* handle() const { return handle_; }
 
+  const std::shared_ptr<detail::Channel_anchor>& anchor() const {
+    return anchor_;
+  }
+
  protected:
   Channel(grpc_channel* handle, Completion_queue* queue)
     : handle_(handle), default_queue_(queue) {}
 
   Channel(Channel&& rhs)     
-    : handle_(rhs.handle_), default_queue_(rhs.default_queue_) {
+    : handle_(rhs.handle_), default_queue_(rhs.default_queue_),
+      anchor_(std::move(rhs.anchor_)) {
     rhs.handle_ = nullptr;
     rhs.default_queue_ = nullptr;
+    rhs.anchor_ = std::make_shared<detail::Channel_anchor>(&rhs);
+
+    std::lock_guard l(anchor_->mtx_);
+    anchor_->channel_ = this;
   }
 
   Channel& operator=(Channel&& rhs) {
+    // Calls made on the channel being replaced can't follow it.
+    retire();
+
     handle_ = rhs.handle_;
     default_queue_ = rhs.default_queue_;
+    anchor_ = std::move(rhs.anchor_);
 
     rhs.handle_ = nullptr;
     rhs.default_queue_ = nullptr;
+    rhs.anchor_ = std::make_shared<detail::Channel_anchor>(&rhs);
+
+    std::lock_guard l(anchor_->mtx_);
+    anchor_->channel_ = this;
     return *this;
   }
 
+  // Stops calls from creating attempts on the channel. Channels with state
+  // of their own invoke it first thing in their destructor, as attempts
+  // can't be created once that state is gone.
+  void retire() {
+    std::lock_guard l(anchor_->mtx_);
+    anchor_->channel_ = nullptr;
+  }
+
  private:
   grpc_channel* handle_ = nullptr;
   Completion_queue* default_queue_ = nullptr;
+  std::shared_ptr<detail::Channel_anchor> anchor_ =
+      std::make_shared<detail::Channel_anchor>(this);
 
   Channel(const Channel&) = delete;
   Channel& operator=(const Channel&) = delete;
 };
+
+namespace detail {
+inline std::optional<Channel_call> Channel_anchor::create_call(
+    void* method_tag, const Call_options& options, std::size_t exclude) {
+  std::lock_guard l(mtx_);
+  if (!channel_) {
+    return std::nullopt;
+  }
+  return channel_->create_call(method_tag, options, exclude);
+}
+}  // namespace detail
 }  // namespace client
 }  // namespace easy_grpc
 #endif
\ No newline at end of file
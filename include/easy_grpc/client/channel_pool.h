@@ -0,0 +1,45 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_CHANNEL_POOL_INCLUDED_H
+#define EASY_GRPC_CLIENT_CHANNEL_POOL_INCLUDED_H
+
+#include "easy_grpc/client/balanced_channel.h"
+
+#include <cstddef>
+#include <string>
+
+namespace easy_grpc {
+namespace client {
+
+// Spreads calls to one address over several HTTP/2 connections, each with its
+// own flow-control window and server-side completion queue thread.
+//
+// Every call goes to a single connection for its whole lifetime, picked when
+// the call is created.
+class Channel_pool : public Balanced_channel {
+ public:
+  enum class Policy {
+    round_robin,
+    least_outstanding,  // The connection with the fewest calls in flight.
+  };
+
+  Channel_pool(const std::string& addr, Completion_queue* default_pool,
+               std::size_t size, Policy policy = Policy::round_robin,
+               const Channel_args& args = {});
+};
+
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_HEDGING_INCLUDED_H
+#define EASY_GRPC_CLIENT_HEDGING_INCLUDED_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace easy_grpc {
+namespace client {
+
+struct Hedging_stats {
+  // Second copies sent because the first one was slow to get a reply.
+  std::atomic<std::uint64_t> hedges_issued = 0;
+
+  // Calls whose reply came from the second copy.
+  std::atomic<std::uint64_t> hedges_won = 0;
+
+  // Second copies that were due, but not sent because the budget was spent.
+  std::atomic<std::uint64_t> hedges_throttled = 0;
+};
+
+// Sends a second copy of a unary call that got no reply within delay. The
+// first successful reply is the one the call's Future gets, and the other
+// copy is cancelled.
+//
+// A policy is meant to be shared by all the calls of a stub, so that its
+// budget caps the extra load hedging puts on the servers: every call earns
+// budget_ratio of a hedge, and up to max_tokens of them can be saved up.
+//
+// Only use this with idempotent methods, as both copies may reach a server.
+class Hedging_policy {
+ public:
+  explicit Hedging_policy(std::chrono::milliseconds delay,
+                          double budget_ratio = 0.1, double max_tokens = 10.0);
+
+  std::chrono::milliseconds delay() const { return delay_; }
+
+  const Hedging_stats& stats() const { return stats_; }
+
+  // Invoked once for every call made with the policy.
+  void on_call();
+
+  // Takes a hedge out of the budget, if there is one left.
+  bool try_hedge();
+
+  void on_hedge_won() { ++stats_.hedges_won; }
+
+ private:
+  // Noncopyable
+  Hedging_policy(const Hedging_policy&) = delete;
+  Hedging_policy& operator=(const Hedging_policy&) = delete;
+
+  std::chrono::milliseconds delay_;
+  double budget_ratio_;
+  double max_tokens_;
+
+  std::mutex mtx_;
+  double tokens_;
+
+  Hedging_stats stats_;
+};
+
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -19,6 +19,7 @@
 
 #include "easy_grpc/client/stub_impl.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,14 +40,39 @@ class Method_stub {
     if (!options.completion_queue) {
       options.completion_queue = default_queue_;
     };
+    if (!options.hedging) {
+      options.hedging = hedging_;
+    }
+    if (!options.retry) {
+      options.retry = retry_;
+    }
     return start_unary_call<OutT>(channel_, tag_, std::move(req),
                                   std::move(options));
   }
 
+  // Makes the call on the calling thread, and blocks until its reply is in.
+  // Cheaper than operator()(req).get() when nothing else is to be done in the
+  // meantime.
+  OutT call_sync(InT req, const Call_options& options = {}) {
+    return call_unary_sync<OutT>(channel_, tag_, std::move(req), options);
+  }
+
+  // Hedges the calls made without a hedging policy of their own.
+  void set_hedging(std::shared_ptr<Hedging_policy> policy) {
+    hedging_ = std::move(policy);
+  }
+
+  // Retries the calls made without a retry policy of their own.
+  void set_retry_policy(std::shared_ptr<const Retry_policy> policy) {
+    retry_ = std::move(policy);
+  }
+
  private:
   Channel* channel_;
   Completion_queue* default_queue_;
   void* tag_;
+  std::shared_ptr<Hedging_policy> hedging_;
+  std::shared_ptr<const Retry_policy> retry_;
 };
 
 }  // namespace client
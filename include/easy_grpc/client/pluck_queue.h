@@ -0,0 +1,36 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_PLUCK_QUEUE_INCLUDED_H
+#define EASY_GRPC_CLIENT_PLUCK_QUEUE_INCLUDED_H
+
+#include "grpc/grpc.h"
+
+namespace easy_grpc {
+namespace client {
+namespace detail {
+
+// A completion queue private to the calling thread, on which blocking calls
+// wait with grpc_completion_queue_pluck(). Created on first use, and
+// destroyed when the thread exits.
+grpc_completion_queue* thread_pluck_queue();
+
+// Destroys the pluck queue of every thread. Invoked by ~Environment(), so no
+// call may be waiting on one by then.
+void shutdown_pluck_queues();
+
+}  // namespace detail
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -0,0 +1,51 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_CLIENT_RETRY_POLICY_INCLUDED_H
+#define EASY_GRPC_CLIENT_RETRY_POLICY_INCLUDED_H
+
+#include "grpc/grpc.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace easy_grpc {
+namespace client {
+
+// How a failed unary call is sent again.
+//
+// The n-th retry waits a random delay between 0 and
+// min(initial_backoff * backoff_multiplier^(n-1), max_backoff), so that
+// clients that failed together do not all come back at the same time. No
+// retry is made if it could not start before the call's deadline.
+struct Retry_policy {
+  // Attempts in total, the first one included.
+  std::size_t max_attempts = 3;
+
+  std::vector<grpc_status_code> retryable_codes = {GRPC_STATUS_UNAVAILABLE};
+
+  std::chrono::milliseconds initial_backoff = std::chrono::milliseconds(100);
+  std::chrono::milliseconds max_backoff = std::chrono::seconds(2);
+  double backoff_multiplier = 2.0;
+
+  bool is_retryable(grpc_status_code code) const;
+
+  // Picks how long to wait before the retry-th retry, starting at 1.
+  std::chrono::milliseconds backoff(std::size_t retry) const;
+};
+
+}  // namespace client
+}  // namespace easy_grpc
+#endif
@@ -15,39 +15,99 @@
 #ifndef EASY_GRPC_CLIENT_STUB_IMPL_INCLUDED_H
 #define EASY_GRPC_CLIENT_STUB_IMPL_INCLUDED_H
 
+#include "easy_grpc/alarm.h"
 #include "easy_grpc/completion_queue.h"
+#include "easy_grpc/compression.h"
 #include "easy_grpc/error.h"
 #include "easy_grpc/serialize.h"
+#include "easy_grpc/stream_writer.h"
+#include "easy_grpc/client/call_options.h"
 #include "easy_grpc/client/channel.h"
+#include "easy_grpc/client/pluck_queue.h"
 
 #include "grpc/grpc.h"
 #include "grpc/support/alloc.h"
 
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <iostream>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
 
 namespace easy_grpc {
 
 namespace client {
-struct Call_options {
-  Completion_queue* completion_queue = nullptr;
-  gpr_timespec deadline = gpr_inf_future(GPR_CLOCK_REALTIME);
-};
-
 //*********************************************************************************//
 namespace detail {
+// Fills op with the initial metadata of a call made with options. md is used
+// as storage, and must outlive the start of the batch.
+inline void op_send_initial_metadata(grpc_op& op, const Call_options& options,
+                                     grpc_metadata& md) {
+  op.op = GRPC_OP_SEND_INITIAL_METADATA;
+  op.flags = 0;
+  op.reserved = nullptr;
+  op.data.send_initial_metadata.count = 0;
+  op.data.send_initial_metadata.metadata = nullptr;
+  op.data.send_initial_metadata.maybe_compression_level.is_set = 0;
+
+  const char* algorithm = nullptr;
+  if (options.compression &&
+      grpc_compression_algorithm_name(*options.compression, &algorithm)) {
+    md.key = grpc_slice_from_static_string(
+        GRPC_COMPRESSION_REQUEST_ALGORITHM_MD_KEY);
+    md.value = grpc_slice_from_static_string(algorithm);
+    op.data.send_initial_metadata.count = 1;
+    op.data.send_initial_metadata.metadata = &md;
+  }
+}
+
+// Fulfills rep with the reply in buffer, or fails it if the reply can't be
+// parsed.
 template <typename RepT>
-class Unary_call_completion final : public Completion_callback {
+void set_reply(Promise<RepT>& rep, grpc_byte_buffer* buffer) {
+  try {
+    rep.set_value(deserialize<RepT>(buffer));
+  } catch (...) {
+    rep.set_exception(std::current_exception());
+  }
+}
+
+// Cancels call with the status matching error, which the call's status then
+// reports.
+inline void cancel_with_error(grpc_call* call, std::exception_ptr error) {
+  grpc_status_code code = GRPC_STATUS_UNKNOWN;
+  std::string details;
+  try {
+    std::rethrow_exception(error);
+  } catch (Rpc_error& e) {
+    code = e.code();
+    details = e.what();
+  } catch (std::exception& e) {
+    details = e.what();
+  } catch (...) {
+  }
+  grpc_call_cancel_with_status(call, code, details.c_str(), nullptr);
+}
+
+// The grpc side of a unary call: its single batch, and where the reply and
+// status land.
+class Unary_call_ops {
  public:
-  Unary_call_completion(grpc_call* call) : call_(call) {
+  explicit Unary_call_ops(Channel_call call)
+      : call_(call.call), in_flight_(std::move(call.in_flight)) {
     grpc_metadata_array_init(&trailing_metadata_);
     grpc_metadata_array_init(&server_metadata_);
   }
 
-  ~Unary_call_completion() {
+  ~Unary_call_ops() {
     grpc_metadata_array_destroy(&server_metadata_);
     grpc_metadata_array_destroy(&trailing_metadata_);
+    grpc_slice_unref(status_details_);
+    gpr_free(const_cast<char*>(error_string_));
 
     if (recv_buffer_) {
       grpc_byte_buffer_destroy(recv_buffer_);
@@ -56,6 +116,93 @@ class Unary_call_completion final : public Completion_callback {
     grpc_call_unref(call_);
   }
 
+  // Sends buffer, and asks for the reply and status, to be delivered as tag.
+  // buffer can be destroyed as soon as this returns.
+  grpc_call_error start(grpc_byte_buffer* buffer, const Call_options& options,
+                        void* tag) {
+    std::array<grpc_op, 6> ops;
+
+    grpc_metadata metadata;
+    op_send_initial_metadata(ops[0], options, metadata);
+
+    ops[1].op = GRPC_OP_SEND_MESSAGE;
+    ops[1].flags = 0;
+    ops[1].reserved = nullptr;
+    ops[1].data.send_message.send_message = buffer;
+
+    ops[2].op = GRPC_OP_RECV_INITIAL_METADATA;
+    ops[2].flags = 0;
+    ops[2].reserved = 0;
+    ops[2].data.recv_initial_metadata.recv_initial_metadata =
+        &server_metadata_;
+
+    ops[3].op = GRPC_OP_RECV_MESSAGE;
+    ops[3].flags = 0;
+    ops[3].reserved = 0;
+    ops[3].data.recv_message.recv_message = &recv_buffer_;
+
+    ops[4].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
+    ops[4].flags = 0;
+    ops[4].reserved = 0;
+
+    ops[5].op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+    ops[5].flags = 0;
+    ops[5].reserved = 0;
+    ops[5].data.recv_status_on_client.trailing_metadata = &trailing_metadata_;
+    ops[5].data.recv_status_on_client.status = &status_;
+    ops[5].data.recv_status_on_client.status_details = &status_details_;
+    ops[5].data.recv_status_on_client.error_string = &error_string_;
+
+    return grpc_call_start_batch(call_, ops.data(), ops.size(), tag, nullptr);
+  }
+
+  // The error matching a status other than GRPC_STATUS_OK.
+  std::exception_ptr error() const {
+    try {
+      auto str = grpc_slice_to_c_string(status_details_);
+      auto err = Rpc_error(status_, str);
+      gpr_free(str);
+      throw err;
+    } catch (...) {
+      return std::current_exception();
+    }
+  }
+
+  grpc_call* call_;
+  In_flight_token in_flight_;
+  grpc_metadata_array server_metadata_;
+  grpc_byte_buffer* recv_buffer_ = nullptr;
+
+  grpc_metadata_array trailing_metadata_;
+  grpc_status_code status_;
+  grpc_slice status_details_ = grpc_empty_slice();
+  const char* error_string_ = nullptr;
+};
+
+template <typename RepT>
+class Unary_call_completion;
+
+// Takes over the outcome of the attempts of a unary call that may be sent
+// more than once.
+template <typename RepT>
+class Unary_attempt_owner {
+ public:
+  virtual ~Unary_attempt_owner() {}
+
+  virtual void on_reply(Unary_call_completion<RepT>& attempt) = 0;
+};
+
+template <typename RepT>
+class Unary_call_completion final : public Completion_callback,
+                                    public Unary_call_ops {
+ public:
+  Unary_call_completion(Channel_call call)
+      : Unary_call_ops(std::move(call)) {}
+
+  grpc_call_error start(grpc_byte_buffer* buffer, const Call_options& options) {
+    return Unary_call_ops::start(buffer, options, completion_tag().data);
+  }
+
   void fail() {
     try {
       throw error::internal("failed to start call");
@@ -65,88 +212,315 @@ class Unary_call_completion final : public Completion_callback {
   }
 
   bool exec(bool, std::bitset<4>) noexcept override {
-    if (status_ == GRPC_STATUS_OK) {
-      rep_.set_value(deserialize<RepT>(recv_buffer_));
+    if (owner_) {
+      owner_->on_reply(*this);
+    } else if (status_ == GRPC_STATUS_OK) {
+      set_reply(rep_, recv_buffer_);
     } else {
-      try {
-        auto str = grpc_slice_to_c_string(status_details_);
-        auto err = Rpc_error(status_, str);
-        gpr_free(str);
-        throw err;
-      } catch (...) {
-        rep_.set_exception(std::current_exception());
+      rep_.set_exception(error());
+    }
+    return true;
+  }
+
+  Promise<RepT> rep_;
+
+  // Set if this is one of the attempts of a hedged or retried call, in which
+  // case the owner gets the reply instead of rep_.
+  Unary_attempt_owner<RepT>* owner_ = nullptr;
+  std::size_t attempt_index_ = 0;
+};
+
+// A unary call sent a second time if its first copy is slow to get a reply.
+//
+// The call's Future gets the first successful reply, or the last error once
+// no copy is left in flight. Attempts and the pending alarm each hold a
+// reference, and the last one to go deletes the call. The alarm is cancelled
+// as soon as the call is settled, so that it doesn't hold its queue back.
+template <typename RepT>
+class Hedged_unary_call final : public Completion_callback,
+                                public Unary_attempt_owner<RepT> {
+ public:
+  static Future<RepT> start(Channel* channel, void* tag,
+                            grpc_byte_buffer* request, Call_options options) {
+    auto hedged =
+        new Hedged_unary_call(channel, tag, request, std::move(options));
+    auto result = hedged->rep_.get_future();
+    const auto& opts = hedged->options_;
+    opts.hedging->on_call();
+
+    std::unique_lock l(hedged->mtx_);
+    if (!hedged->send(0)) {
+      l.unlock();
+      hedged->rep_.set_exception(
+          std::make_exception_ptr(error::internal("failed to start call")));
+      delete hedged;
+      return result;
+    }
+
+    // No point in hedging past the call's deadline.
+    auto hedge_at =
+        gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC),
+                     gpr_time_from_millis(opts.hedging->delay().count(),
+                                          GPR_TIMESPAN));
+    if (gpr_time_cmp(hedge_at, gpr_convert_clock_type(
+                                   opts.deadline, GPR_CLOCK_MONOTONIC)) < 0) {
+      ++hedged->refs_;
+      hedged->alarm_.emplace(opts.completion_queue, hedge_at,
+                             hedged->completion_tag());
+    } else {
+      grpc_byte_buffer_destroy(hedged->request_);
+      hedged->request_ = nullptr;
+    }
+    return result;
+  }
+
+  ~Hedged_unary_call() {
+    for (auto call : calls_) {
+      if (call) {
+        grpc_call_unref(call);
       }
     }
+    if (request_) {
+      grpc_byte_buffer_destroy(request_);
+    }
+  }
+
+  // The hedge delay is over, or the alarm was cancelled.
+  bool exec(bool, std::bitset<4>) noexcept override {
+    {
+      std::lock_guard l(mtx_);
+      if (!done_ && !alarm_->cancelled() && options_.hedging->try_hedge()) {
+        // If that fails, the first copy is still on its way.
+        send(1);
+      }
+      grpc_byte_buffer_destroy(request_);
+      request_ = nullptr;
+      alarm_.reset();
+    }
+    unref();
+    return false;
+  }
+
+  void on_reply(Unary_call_completion<RepT>& attempt) override {
+    bool won = false;
+    bool failed = false;
+    {
+      std::lock_guard l(mtx_);
+      --pending_;
+      if (!done_ && attempt.status_ == GRPC_STATUS_OK) {
+        done_ = won = true;
+        auto other = calls_[1 - attempt.attempt_index_];
+        if (other) {
+          grpc_call_cancel(other, nullptr);
+        }
+      } else if (!done_ && pending_ == 0) {
+        done_ = failed = true;
+      }
+
+      if (done_ && alarm_) {
+        alarm_->cancel();
+      }
+    }
+
+    if (won) {
+      if (attempt.attempt_index_ == 1) {
+        options_.hedging->on_hedge_won();
+      }
+      set_reply(rep_, attempt.recv_buffer_);
+    } else if (failed) {
+      rep_.set_exception(attempt.error());
+    }
+    unref();
+  }
+
+ private:
+  Hedged_unary_call(Channel* channel, void* tag, grpc_byte_buffer* request,
+                    Call_options options)
+      : channel_(channel->anchor()),
+        tag_(tag),
+        options_(std::move(options)),
+        request_(grpc_byte_buffer_copy(request)) {}
+
+  // Sends copy index of the request. Invoked with mtx_ held.
+  bool send(std::size_t index) {
+    // The hedge is pointless on the endpoint that's slow to answer the first
+    // copy.
+    auto call = channel_->create_call(
+        tag_, options_, index == 0 ? Channel::no_endpoint : first_endpoint_);
+    if (!call) {
+      return false;
+    }
+    auto endpoint = call->endpoint;
+    auto attempt = new Unary_call_completion<RepT>(std::move(*call));
+    attempt->owner_ = this;
+    attempt->attempt_index_ = index;
+
+    ++refs_;
+    if (attempt->start(request_, options_) != GRPC_CALL_OK) {
+      --refs_;
+      delete attempt;
+      return false;
+    }
+
+    calls_[index] = attempt->call_;
+    grpc_call_ref(calls_[index]);
+    if (index == 0) {
+      first_endpoint_ = endpoint;
+    }
+    ++pending_;
     return true;
   }
 
-  grpc_call* call_;
-  grpc_metadata_array server_metadata_;
+  void unref() {
+    if (--refs_ == 0) {
+      delete this;
+    }
+  }
+
+  std::shared_ptr<Channel_anchor> channel_;
+  void* tag_;
+  Call_options options_;
   Promise<RepT> rep_;
-  grpc_byte_buffer* recv_buffer_;
 
-  grpc_metadata_array trailing_metadata_;
-  grpc_status_code status_;
-  grpc_slice status_details_;
-  const char* error_string_;
+  std::atomic<int> refs_ = 0;
+
+  std::mutex mtx_;
+  grpc_byte_buffer* request_;
+  std::optional<Alarm> alarm_;
+  std::array<grpc_call*, 2> calls_ = {};
+  std::size_t first_endpoint_ = Channel::no_endpoint;
+  std::size_t pending_ = 0;
+  bool done_ = false;
 };
-}  // namespace detail
 
+// A unary call sent again, after a backoff, when it fails with a retryable
+// code. There is at most one attempt or backoff pending at any time, and
+// the call deletes itself once its Future is fulfilled. A backoff cut short
+// by its queue going away fails the call with the last attempt's error.
+template <typename RepT>
+class Retrying_unary_call final : public Completion_callback,
+                                  public Unary_attempt_owner<RepT> {
+ public:
+  static Future<RepT> start(Channel* channel, void* tag,
+                            grpc_byte_buffer* request, Call_options options) {
+    auto retrying =
+        new Retrying_unary_call(channel, tag, request, std::move(options));
+    auto result = retrying->rep_.get_future();
+    retrying->send();
+    return result;
+  }
 
-template <typename RepT, typename ReqT>
-Future<RepT> start_unary_call(Channel* channel, void* tag, const ReqT& req,
-                              Call_options options) {
-  assert(options.completion_queue);
+  ~Retrying_unary_call() { grpc_byte_buffer_destroy(request_); }
 
-  auto call = grpc_channel_create_registered_call(
-      channel->handle(), nullptr, GRPC_PROPAGATE_DEFAULTS,
-      options.completion_queue->handle(), tag, options.deadline, nullptr);
-  auto completion = new detail::Unary_call_completion<RepT>(call);
-  auto buffer = serialize(req);
+  // The backoff is over, or the alarm was cancelled.
+  bool exec(bool, std::bitset<4>) noexcept override {
+    bool cancelled = backoff_->cancelled();
+    backoff_.reset();
 
-  std::array<grpc_op, 6> ops;
+    if (cancelled) {
+      rep_.set_exception(last_error_);
+      delete this;
+    } else {
+      send();
+    }
+    return false;
+  }
 
-  ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-  ops[0].flags = 0;
-  ops[0].reserved = nullptr;
-  ops[0].data.send_initial_metadata.count = 0;
-  ops[0].data.send_initial_metadata.maybe_compression_level.is_set = 0;
+  void on_reply(Unary_call_completion<RepT>& attempt) override {
+    if (attempt.status_ == GRPC_STATUS_OK) {
+      set_reply(rep_, attempt.recv_buffer_);
+      delete this;
+      return;
+    }
 
-  ops[1].op = GRPC_OP_SEND_MESSAGE;
-  ops[1].flags = 0;
-  ops[1].reserved = nullptr;
-  ops[1].data.send_message.send_message = buffer;
+    const auto& policy = *options_.retry;
+    if (attempts_ < policy.max_attempts &&
+        policy.is_retryable(attempt.status_)) {
+      auto retry_at = gpr_time_add(
+          gpr_now(GPR_CLOCK_MONOTONIC),
+          gpr_time_from_millis(policy.backoff(attempts_).count(),
+                               GPR_TIMESPAN));
+      if (gpr_time_cmp(retry_at, gpr_convert_clock_type(
+                                     options_.deadline, GPR_CLOCK_MONOTONIC)) <
+          0) {
+        last_error_ = attempt.error();
+        backoff_.emplace(options_.completion_queue, retry_at,
+                         completion_tag());
+        return;
+      }
+    }
 
-  ops[2].op = GRPC_OP_RECV_INITIAL_METADATA;
-  ops[2].flags = 0;
-  ops[2].reserved = 0;
-  ops[2].data.recv_initial_metadata.recv_initial_metadata =
-      &completion->server_metadata_;
+    rep_.set_exception(attempt.error());
+    delete this;
+  }
 
-  ops[3].op = GRPC_OP_RECV_MESSAGE;
-  ops[3].flags = 0;
-  ops[3].reserved = 0;
-  ops[3].data.recv_message.recv_message = &completion->recv_buffer_;
+ private:
+  Retrying_unary_call(Channel* channel, void* tag, grpc_byte_buffer* request,
+                      Call_options options)
+      : channel_(channel->anchor()),
+        tag_(tag),
+        options_(std::move(options)),
+        request_(grpc_byte_buffer_copy(request)) {}
+
+  void send() {
+    auto call = channel_->create_call(tag_, options_, Channel::no_endpoint);
+    if (!call) {
+      rep_.set_exception(std::make_exception_ptr(
+          error::unavailable("channel destroyed before the call could retry")));
+      delete this;
+      return;
+    }
 
-  ops[4].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
-  ops[4].flags = 0;
-  ops[4].reserved = 0;
+    auto attempt = new Unary_call_completion<RepT>(std::move(*call));
+    attempt->owner_ = this;
+    attempt->attempt_index_ = attempts_++;
 
-  ops[5].op = GRPC_OP_RECV_STATUS_ON_CLIENT;
-  ops[5].flags = 0;
-  ops[5].reserved = 0;
-  ops[5].data.recv_status_on_client.trailing_metadata =
-      &completion->trailing_metadata_;
-  ops[5].data.recv_status_on_client.status = &completion->status_;
-  ops[5].data.recv_status_on_client.status_details =
-      &completion->status_details_;
-  ops[5].data.recv_status_on_client.error_string = &completion->error_string_;
+    if (attempt->start(request_, options_) != GRPC_CALL_OK) {
+      delete attempt;
+      rep_.set_exception(
+          std::make_exception_ptr(error::internal("failed to start call")));
+      delete this;
+    }
+  }
 
-  auto result = completion->rep_.get_future();
-  auto status =
-      grpc_call_start_batch(call, ops.data(), ops.size(), completion, nullptr);
+  std::shared_ptr<Channel_anchor> channel_;
+  void* tag_;
+  Call_options options_;
+  Promise<RepT> rep_;
 
-  if (status != GRPC_CALL_OK) {
+  grpc_byte_buffer* request_;
+  std::size_t attempts_ = 0;
+  std::optional<Alarm> backoff_;
+  std::exception_ptr last_error_;
+};
+}  // namespace detail
+
+
+template <typename RepT, typename ReqT>
+Future<RepT> start_unary_call(Channel* channel, void* tag, ReqT req,
+                              Call_options options) {
+  assert(options.completion_queue);
+
+  auto buffer = serialize(std::move(req));
+  if (options.hedging) {
+    auto result = detail::Hedged_unary_call<RepT>::start(
+        channel, tag, buffer, std::move(options));
+    grpc_byte_buffer_destroy(buffer);
+    return result;
+  }
+
+  if (options.retry && options.retry->max_attempts > 1) {
+    auto result = detail::Retrying_unary_call<RepT>::start(
+        channel, tag, buffer, std::move(options));
+    grpc_byte_buffer_destroy(buffer);
+    return result;
+  }
+
+  auto call = channel->create_call(tag, options);
+  auto completion = new detail::Unary_call_completion<RepT>(std::move(call));
+
+  auto result = completion->rep_.get_future();
+  if (completion->start(buffer, options) != GRPC_CALL_OK) {
     completion->fail();
     delete completion;
   }
@@ -156,13 +530,44 @@ Future<RepT> start_unary_call(Channel* channel, void* tag, const ReqT& req,
   return result;
 }
 
+// Makes a unary call, and waits for its reply on the calling thread's pluck
+// queue. This skips the hop to a completion queue thread and the Future.
+//
+// options.completion_queue is not used, nor are hedging and retries.
+template <typename RepT, typename ReqT>
+RepT call_unary_sync(Channel* channel, void* tag, ReqT req,
+                     const Call_options& options) {
+  auto queue = detail::thread_pluck_queue();
+  detail::Unary_call_ops call(
+      channel->create_call(tag, options, queue, Channel::no_endpoint));
+
+  auto buffer = serialize(std::move(req));
+  auto status = call.start(buffer, options, &call);
+  grpc_byte_buffer_destroy(buffer);
+
+  if (status != GRPC_CALL_OK) {
+    throw error::internal("failed to start call");
+  }
+
+  auto event = grpc_completion_queue_pluck(
+      queue, &call, gpr_inf_future(GPR_CLOCK_REALTIME), nullptr);
+  assert(event.type == GRPC_OP_COMPLETE);
+  (void)event;
+
+  if (call.status_ != GRPC_STATUS_OK) {
+    std::rethrow_exception(call.error());
+  }
+  return deserialize<RepT>(call.recv_buffer_);
+}
+
 //*********************************************************************************//
 
 namespace detail {
 template <typename RepT>
 class Streaming_call_session final : public Completion_callback {
  public:
-  Streaming_call_session(grpc_call* call) : call_(call) {
+  Streaming_call_session(Channel_call call)
+      : call_(call.call), in_flight_(std::move(call.in_flight)) {
     grpc_metadata_array_init(&trailing_metadata_);
     grpc_metadata_array_init(&server_metadata_);
   }
@@ -170,6 +575,8 @@ class Streaming_call_session final : public Completion_callback {
   ~Streaming_call_session() {
     grpc_metadata_array_destroy(&server_metadata_);
     grpc_metadata_array_destroy(&trailing_metadata_);
+    grpc_slice_unref(status_details_);
+    gpr_free(const_cast<char*>(error_string_));
 
     if (recv_buffer_) {
       grpc_byte_buffer_destroy(recv_buffer_);
@@ -182,10 +589,9 @@ class Streaming_call_session final : public Completion_callback {
     bool all_done = finishing_;
 
     if(!all_done) {
-      if( recv_buffer_) {
-        auto data = recv_buffer_;
-        recv_buffer_ = nullptr;
-
+      // Push before asking for the next message, otherwise another thread
+      // of the queue could deliver it first.
+      if(recv_buffer_ && push_reply_()) {
         std::array<grpc_op, 1> ops;
 
         ops[0].op = GRPC_OP_RECV_MESSAGE;
@@ -199,9 +605,6 @@ class Streaming_call_session final : public Completion_callback {
         if (call_status != GRPC_CALL_OK) {
           assert(false);
         }
-
-        reply_stream_promise_.push(deserialize<RepT>(data));
-        grpc_byte_buffer_destroy(data);
       }
       else {
         std::array<grpc_op, 2> ops;
@@ -243,7 +646,24 @@ class Streaming_call_session final : public Completion_callback {
     return all_done;
   }
 
+  // Returns false, and cancels the call, if the reply can't be parsed.
+  bool push_reply_() {
+    auto data = recv_buffer_;
+    recv_buffer_ = nullptr;
+
+    bool parsed = true;
+    try {
+      reply_stream_promise_.push(deserialize<RepT>(data));
+    } catch (...) {
+      cancel_with_error(call_, std::current_exception());
+      parsed = false;
+    }
+    grpc_byte_buffer_destroy(data);
+    return parsed;
+  }
+
   grpc_call* call_;
+  In_flight_token in_flight_;
   Stream_promise<RepT> reply_stream_promise_;
   grpc_byte_buffer* recv_buffer_ = nullptr;
 
@@ -251,28 +671,25 @@ class Streaming_call_session final : public Completion_callback {
   grpc_metadata_array server_metadata_;
   grpc_metadata_array trailing_metadata_;
   grpc_status_code status_;
-  grpc_slice status_details_;
-  const char* error_string_;
+  grpc_slice status_details_ = grpc_empty_slice();
+  const char* error_string_ = nullptr;
 };
 }  // namespace detail
 
 template <typename RepT, typename ReqT>
-Stream_future<RepT> start_server_streaming_call(Channel* channel, void* tag, const ReqT& req, Call_options options) {
+Stream_future<RepT> start_server_streaming_call(Channel* channel, void* tag, ReqT req, Call_options options) {
  assert(options.completion_queue);
 
-  auto call = grpc_channel_create_registered_call(
-      channel->handle(), nullptr, GRPC_PROPAGATE_DEFAULTS,
-      options.completion_queue->handle(), tag, options.deadline, nullptr);
-  auto completion = new detail::Streaming_call_session<RepT>(call);
-  auto send_buffer = serialize(req);
+  auto call = channel->create_call(tag, options);
+  auto completion = new detail::Streaming_call_session<RepT>(std::move(call));
+  // The session may start receiving as soon as the batch is started.
+  auto result = completion->reply_stream_promise_.get_future();
+  auto send_buffer = serialize(std::move(req));
 
   std::array<grpc_op, 4> ops;
 
-  ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-  ops[0].flags = 0;
-  ops[0].reserved = nullptr;
-  ops[0].data.send_initial_metadata.count = 0;
-  ops[0].data.send_initial_metadata.maybe_compression_level.is_set = 0;
+  grpc_metadata metadata;
+  detail::op_send_initial_metadata(ops[0], options, metadata);
 
   ops[1].op = GRPC_OP_SEND_MESSAGE;
   ops[1].flags = 0;
@@ -299,7 +716,7 @@ Stream_future<RepT> start_server_streaming_call(Channel* channel, void* tag, con
 
   grpc_byte_buffer_destroy(send_buffer);
 
-  return completion->reply_stream_promise_.get_future();
+  return result;
 }
 
 
@@ -309,59 +726,38 @@ Stream_future<RepT> start_server_streaming_call(Channel* channel, void* tag, con
 //
 template<typename RepT, typename ReqT>
 class Client_streaming_call_session final 
-  : public Completion_callback {
+  : public Completion_callback, public easy_grpc::detail::Message_sink {
 public:
-  Client_streaming_call_session(grpc_call* call) 
-    : call_(call) {
+  Client_streaming_call_session(Channel_call call, std::size_t capacity, bool coalesce) 
+    : call_(call.call), in_flight_(std::move(call.in_flight)),
+      writer_(std::make_shared<writer_type>(capacity, coalesce)) {
     grpc_metadata_array_init(&trailing_metadata_);
     grpc_metadata_array_init(&server_metadata_);
+  }
 
+  // Separate from the constructor, the completion can come in as soon as
+  // the batch is started.
+  void start(const Call_options& options) {
     std::array<grpc_op, 2> pending_ops;
     
-    pending_ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-    pending_ops[0].flags = 0;
-    pending_ops[0].reserved = nullptr;
-    pending_ops[0].data.send_initial_metadata.count = 0;
-    pending_ops[0].data.send_initial_metadata.maybe_compression_level.is_set = 0;
+    grpc_metadata metadata;
+    detail::op_send_initial_metadata(pending_ops[0], options, metadata);
 
     pending_ops[1].op = GRPC_OP_RECV_INITIAL_METADATA;
     pending_ops[1].flags = 0;
     pending_ops[1].reserved = 0;
     pending_ops[1].data.recv_initial_metadata.recv_initial_metadata = &server_metadata_;
 
-    grpc_call_start_batch(call_, pending_ops.data(), pending_ops.size(), completion_tag().data, nullptr);
-    batch_in_flight_ = true;
-
-    req_.get_future().for_each([this](ReqT req){
-      std::lock_guard l(mtx_);
-
-      auto buffer = serialize(req);
-      
-      grpc_op op;
-      op.op = GRPC_OP_SEND_MESSAGE;
-      op.flags = 0;
-      op.reserved = nullptr;
-      op.data.send_message.send_message = buffer;
-
-      pending_ops_.push(op);
-
-      // Send whatever we have.
-      flush_();
-    }).finally([this](expected<void>) {
-      std::lock_guard l(mtx_);
-      finished_ = true;
-      
-      if(!batch_in_flight_) {
-        send_end();
-      }
-    });
+    auto status = grpc_call_start_batch(call_, pending_ops.data(), pending_ops.size(), completion_tag(2).data, nullptr);
+    assert(status == GRPC_CALL_OK);
+    (void)status;
   }
 
   ~Client_streaming_call_session() {
-    assert(pending_ops_.empty());
-
     grpc_metadata_array_destroy(&server_metadata_);
     grpc_metadata_array_destroy(&trailing_metadata_);
+    grpc_slice_unref(status_details_);
+    gpr_free(const_cast<char*>(error_string_));
 
     if (recv_buffer_) {
       grpc_byte_buffer_destroy(recv_buffer_);
@@ -370,17 +766,12 @@ public:
     grpc_call_unref(call_);
   }
 
-  void flush_() {
-    if(batch_in_flight_) {
-      return ;
-    }
-
-    batch_in_flight_ = true;
-
-    auto op = pending_ops_.front();
-    pending_ops_.pop();
-
-    assert(op.op == GRPC_OP_SEND_MESSAGE);
+  void write(grpc_byte_buffer* buffer, bool buffered) override {
+    grpc_op op;
+    op.op = GRPC_OP_SEND_MESSAGE;
+    op.flags = buffered ? GRPC_WRITE_BUFFER_HINT : 0;
+    op.reserved = nullptr;
+    op.data.send_message.send_message = buffer;
     
     auto status =
       grpc_call_start_batch(call_, &op, 1, completion_tag().data, nullptr);
@@ -390,10 +781,15 @@ public:
     }
     assert(status == GRPC_CALL_OK);
     
-    grpc_byte_buffer_destroy(op.data.send_message.send_message);
+    grpc_byte_buffer_destroy(buffer);
   }
 
-  void send_end() {
+  // Half-closes the call, and waits for the server's reply.
+  void close(std::exception_ptr error) override {
+    if(error) {
+      grpc_call_cancel(call_, nullptr);
+    }
+
     std::array<grpc_op, 3> ops;
 
     ops[0].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
@@ -416,149 +812,152 @@ public:
     ops[2].data.recv_status_on_client.error_string = &error_string_;
 
     auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag().data, nullptr);
+      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(4).data, nullptr);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
     }
     assert(status == GRPC_CALL_OK);
-
-    end_sent_ = true;
-
   }
 
-  bool exec(bool, std::bitset<4>) noexcept override {
-    std::lock_guard l(mtx_);
-    batch_in_flight_ = false;
+  bool exec(bool ok, std::bitset<4> flags) noexcept override {
+    bool handshake = flags.test(1);
+    bool closing = flags.test(2);
 
-    if(!pending_ops_.empty()) {
-      flush_();
+    if(handshake) {
+      writer_->attach(this, ok);
       return false;
     }
 
-    if(finished_) {
-      if(end_sent_) {
-        if (status_ == GRPC_STATUS_OK) {
-          rep_.set_value(deserialize<RepT>(recv_buffer_));
-        } else {
-        try {
-          auto str = grpc_slice_to_c_string(status_details_);
-          auto err = Rpc_error(status_, str);
-          gpr_free(str);
-          throw err;
-        } catch (...) {
-          rep_.set_exception(std::current_exception());
-        }
-      
-      }
+    if(!closing) {
+      writer_->on_written(ok);
+      return false;
+    }
 
-        return true;
+    writer_->detach();
+    if (status_ == GRPC_STATUS_OK && recv_buffer_) {
+      detail::set_reply(rep_, recv_buffer_);
+    } else if (status_ == GRPC_STATUS_OK) {
+      rep_.set_exception(std::make_exception_ptr(error::internal("missing reply")));
+    } else {
+      try {
+        auto str = grpc_slice_to_c_string(status_details_);
+        auto err = Rpc_error(status_, str);
+        gpr_free(str);
+        throw err;
+      } catch (...) {
+        rep_.set_exception(std::current_exception());
       }
-      send_end();
     }
 
-    return false;
+    return true;
   }
 
-  // I really wish we could do this without a mutex, somehow...
-  std::mutex mtx_;
-  bool batch_in_flight_ = false;
-  bool finished_ = false;
-  bool end_sent_ = false;
+  using writer_type = easy_grpc::detail::Writer_state<ReqT>;
 
   grpc_call* call_;
+  In_flight_token in_flight_;
   grpc_metadata_array server_metadata_;
 
-  Stream_promise<ReqT> req_;
+  std::shared_ptr<writer_type> writer_;
   Promise<RepT> rep_;
   
-  grpc_byte_buffer* recv_buffer_;
+  grpc_byte_buffer* recv_buffer_ = nullptr;
 
   grpc_metadata_array trailing_metadata_;
-  grpc_status_code status_;
-  grpc_slice status_details_;
-  const char* error_string_;
-
-  std::queue<grpc_op> pending_ops_;
+  grpc_status_code status_ = GRPC_STATUS_UNKNOWN;
+  grpc_slice status_details_ = grpc_empty_slice();
+  const char* error_string_ = nullptr;
 };
 
+namespace detail {
+// Forwards the requests pushed on a Stream_promise to the call's writer.
+template <typename ReqT>
+Stream_promise<ReqT> feed_writer(std::shared_ptr<easy_grpc::detail::Writer_state<ReqT>> writer) {
+  Stream_promise<ReqT> result;
+
+  result.get_future().for_each([writer](ReqT req) {
+    writer->push(std::move(req));
+  }).finally([writer](expected<void> status) {
+    if (status.has_value()) {
+      writer->complete();
+    } else {
+      writer->fail(status.error());
+    }
+  });
+
+  return result;
+}
+}  // namespace detail
+
 template <typename RepT, typename ReqT>
 std::tuple<Stream_promise<ReqT>, Future<RepT>> start_client_streaming_call(Channel* channel, void* tag, Call_options options) {
   assert(options.completion_queue);
 
-  auto call = grpc_channel_create_registered_call(
-      channel->handle(), nullptr, GRPC_PROPAGATE_DEFAULTS,
-      options.completion_queue->handle(), tag, options.deadline, nullptr);
+  auto call = channel->create_call(tag, options);
+
+  // A Stream_promise can't hold its producer back, so nothing bounds the requests.
+  auto call_session = new Client_streaming_call_session<RepT, ReqT>(std::move(call), 0, options.coalesce_writes);  
+
+  auto requests = detail::feed_writer(call_session->writer_);
+  auto result = call_session->rep_.get_future();
+  call_session->start(options);
+
+  return {std::move(requests), std::move(result)};
+}
+
+template <typename RepT, typename ReqT>
+std::tuple<Stream_writer<ReqT>, Future<RepT>> start_client_streaming_call(With_writer, Channel* channel, void* tag, Call_options options) {
+  assert(options.completion_queue);
+
+  auto call = channel->create_call(tag, options);
+
+  auto call_session = new Client_streaming_call_session<RepT, ReqT>(std::move(call), options.stream_capacity, options.coalesce_writes);  
 
-  auto call_session = new Client_streaming_call_session<RepT, ReqT>(call);  
+  Stream_writer<ReqT> writer(call_session->writer_);
+  auto result = call_session->rep_.get_future();
+  call_session->start(options);
 
-  return {std::move(call_session->req_), call_session->rep_.get_future()};
+  return {std::move(writer), std::move(result)};
 }
 
 //*********************************************************************************//
 
 template<typename RepT, typename ReqT>
 class Bidir_streaming_call_session final 
-  : public Completion_callback {
+  : public Completion_callback, public easy_grpc::detail::Message_sink {
 public:
-  Bidir_streaming_call_session(grpc_call* call, Stream_future<ReqT> req_stream) 
-    : call_(call) {
+  using writer_type = easy_grpc::detail::Writer_state<ReqT>;
+
+  Bidir_streaming_call_session(Channel_call call, std::shared_ptr<writer_type> writer, Stream_promise<RepT> rep) 
+    : rep_(std::move(rep)), writer_(std::move(writer)), call_(call.call),
+      in_flight_(std::move(call.in_flight)) {
     grpc_metadata_array_init(&trailing_metadata_);
     grpc_metadata_array_init(&server_metadata_);
+  }
 
-    // Launch the metadata exchange
+  // Launches the metadata exchange.
+  void start(const Call_options& options) {
     std::array<grpc_op, 2> pending_ops;
     
-    pending_ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
-    pending_ops[0].flags = 0;
-    pending_ops[0].reserved = nullptr;
-    pending_ops[0].data.send_initial_metadata.count = 0;
-    pending_ops[0].data.send_initial_metadata.maybe_compression_level.is_set = 0;
+    grpc_metadata metadata;
+    detail::op_send_initial_metadata(pending_ops[0], options, metadata);
 
     pending_ops[1].op = GRPC_OP_RECV_INITIAL_METADATA;
     pending_ops[1].flags = 0;
     pending_ops[1].reserved = 0;
     pending_ops[1].data.recv_initial_metadata.recv_initial_metadata = &server_metadata_;
 
-    can_send_ = false;
-    grpc_call_start_batch(call_, pending_ops.data(), pending_ops.size(), completion_tag(2).data, nullptr);
-
-    // Get ready to send requests
-    req_stream.for_each([this](ReqT req){
-      std::lock_guard l(mtx_);
-
-      auto buffer = serialize(req);
-      
-      grpc_op op;
-      op.op = GRPC_OP_SEND_MESSAGE;
-      op.flags = 0;
-      op.reserved = nullptr;
-      op.data.send_message.send_message = buffer;
-
-      pending_ops_.push(op);
-
-      // Send whatever we have.
-      flush_();
-    }).finally([this](expected<void> s) {
-
-      std::lock_guard l(mtx_);
-      if(!s.has_value()) {
-        grpc_call_cancel(call_, nullptr);
-      }
-
-      finished_sending_ = true;
-      
-      if(can_send_) {
-        send_client_end();
-      }
-    });
+    auto status = grpc_call_start_batch(call_, pending_ops.data(), pending_ops.size(), completion_tag(2).data, nullptr);
+    assert(status == GRPC_CALL_OK);
+    (void)status;
   }
 
   ~Bidir_streaming_call_session() {
-    assert(pending_ops_.empty());
-
     grpc_metadata_array_destroy(&server_metadata_);
     grpc_metadata_array_destroy(&trailing_metadata_);
+    grpc_slice_unref(status_details_);
+    gpr_free(const_cast<char*>(error_string_));
 
     if (recv_buffer_) {
       grpc_byte_buffer_destroy(recv_buffer_);
@@ -567,17 +966,12 @@ public:
     grpc_call_unref(call_);
   }
 
-  void flush_() {
-    if(!can_send_) {
-      return ;
-    }
-
-    can_send_ = false;
-
-    auto op = pending_ops_.front();
-    pending_ops_.pop();
-
-    assert(op.op == GRPC_OP_SEND_MESSAGE);
+  void write(grpc_byte_buffer* buffer, bool buffered) override {
+    grpc_op op;
+    op.op = GRPC_OP_SEND_MESSAGE;
+    op.flags = buffered ? GRPC_WRITE_BUFFER_HINT : 0;
+    op.reserved = nullptr;
+    op.data.send_message.send_message = buffer;
     
     auto status =
       grpc_call_start_batch(call_, &op, 1, completion_tag(1).data, nullptr);
@@ -587,11 +981,14 @@ public:
       assert(false);
     }
     
-    grpc_byte_buffer_destroy(op.data.send_message.send_message);
+    grpc_byte_buffer_destroy(buffer);
   }
 
+  void close(std::exception_ptr error) override {
+    if(error) {
+      grpc_call_cancel(call_, nullptr);
+    }
 
-  void send_client_end() {
     std::array<grpc_op, 1> ops;
 
     ops[0].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
@@ -605,8 +1002,6 @@ public:
       std::cerr << grpc_call_error_to_string(status) << "\n";
     }
     assert(status == GRPC_CALL_OK);
-
-    end_sent_ = true;
   }
 
   void finish() {
@@ -629,36 +1024,30 @@ public:
       std::cerr << grpc_call_error_to_string(status) << "\n";
     }
     assert(status == GRPC_CALL_OK);
-
-    end_sent_ = true;
   }
 
-  bool exec(bool, std::bitset<4> flags) noexcept override {
+  bool exec(bool ok, std::bitset<4> flags) noexcept override {
     bool write_op = flags.test(0);
     bool handshake = flags.test(1);
     bool ending = flags.test(2);
     bool closing = flags.test(3);
 
-    std::cout << "serv_exec: " << flags.to_string() << "\n";
-
     if(closing) {
+      writer_->detach();
       if(status_ == GRPC_STATUS_OK) {
         rep_.complete();
       }
       else {
-        rep_.set_exception(std::make_exception_ptr(Rpc_error(status_, error_string_)));
+        auto str = grpc_slice_to_c_string(status_details_);
+        rep_.set_exception(std::make_exception_ptr(Rpc_error(status_, str)));
+        gpr_free(str);
       }
       return true;
     }
-    
-    std::unique_lock l(mtx_);
 
     if(handshake) {
       // Allow the sending of messages
-      can_send_ = true;
-      if(!pending_ops_.empty()) {
-        flush_();
-      }
+      writer_->attach(this, ok);
 
       // Start receiving messages from the server
       std::array<grpc_op, 1> ops;
@@ -673,31 +1062,22 @@ public:
       if (call_status != GRPC_CALL_OK) {
         assert(false);
       }
-
-      l.unlock();      
     }
     else if(ending) {
+      std::lock_guard l(mtx_);
+      end_acked_ = true;
       if(finished_receiving_) {
         finish();
       }
     }
     else if(write_op) {
       // That was the end of a write op
-      can_send_ = true;
-
-      if(!pending_ops_.empty()) {
-        flush_();
-      }
-      else if(finished_sending_) {
-        send_client_end();
-      }
+      writer_->on_written(ok);
     }
     else {
-      // That was the end of a read op
-      if( recv_buffer_) {
-        auto data = recv_buffer_;
-        recv_buffer_ = nullptr;
-
+      // That was the end of a read op. Push before asking for the next
+      // message, so that the queue's threads cannot reorder the stream.
+      if(recv_buffer_ && push_reply_()) {
         std::array<grpc_op, 1> ops;
 
         ops[0].op = GRPC_OP_RECV_MESSAGE;
@@ -711,15 +1091,14 @@ public:
         if (call_status != GRPC_CALL_OK) {
           assert(false);
         }
-
-        rep_.push(deserialize<RepT>(data));
-        grpc_byte_buffer_destroy(data);
       }
       else {
+        std::lock_guard l(mtx_);
         finished_receiving_ = true;
 
-        //TODO: This is not quite right, I think. We should wait for the status to be received from the server.
-        if(finished_sending_ && end_sent_) {
+        // Only once the end of the client stream has completed, or both
+        // branches would end up requesting the status.
+        if(end_acked_) {
           finish();
         }
       }
@@ -727,41 +1106,77 @@ public:
     return false;
   }
 
+  // Returns false, and cancels the call, if the reply can't be parsed.
+  bool push_reply_() {
+    auto data = recv_buffer_;
+    recv_buffer_ = nullptr;
+
+    bool parsed = true;
+    try {
+      rep_.push(deserialize<RepT>(data));
+    } catch (...) {
+      detail::cancel_with_error(call_, std::current_exception());
+      // Ends the request stream too, which the status waits for.
+      writer_->cancel();
+      parsed = false;
+    }
+    grpc_byte_buffer_destroy(data);
+    return parsed;
+  }
+
   Stream_promise<RepT> rep_;
+  std::shared_ptr<writer_type> writer_;
 
-  // I really wish we could do this without a mutex, somehow...
   std::mutex mtx_;
-  bool can_send_ = false;
-  bool finished_sending_ = false;
   bool finished_receiving_ = false;
-
-  bool end_sent_ = false;
+  bool end_acked_ = false;
 
   grpc_call* call_;
+  In_flight_token in_flight_;
   grpc_metadata_array server_metadata_;
-  grpc_byte_buffer* recv_buffer_;
+  grpc_byte_buffer* recv_buffer_ = nullptr;
 
 
   grpc_metadata_array trailing_metadata_;
-  grpc_status_code status_;
-  grpc_slice status_details_;
-  const char* error_string_;
-
-  std::queue<grpc_op> pending_ops_;
+  grpc_status_code status_ = GRPC_STATUS_UNKNOWN;
+  grpc_slice status_details_ = grpc_empty_slice();
+  const char* error_string_ = nullptr;
 };
 
 template <typename RepT, typename ReqT>
 std::tuple<Stream_promise<ReqT>, Stream_future<RepT>> start_bidir_streaming_call(Channel* channel, void* tag, Call_options options) {
   assert(options.completion_queue);
 
-  auto call = grpc_channel_create_registered_call(
-      channel->handle(), nullptr, GRPC_PROPAGATE_DEFAULTS,
-      options.completion_queue->handle(), tag, options.deadline, nullptr);
+  auto call = channel->create_call(tag, options);
+
+  // A Stream_promise can't hold its producer back, so nothing bounds the requests.
+  auto writer = std::make_shared<easy_grpc::detail::Writer_state<ReqT>>(
+      0, options.coalesce_writes);
+  auto requests = detail::feed_writer(writer);
+  Stream_promise<RepT> rep;
+  auto rep_stream = rep.get_future();
+
+  auto session = new Bidir_streaming_call_session<RepT, ReqT>(std::move(call), std::move(writer), std::move(rep));
+  session->start(options);
+
+  return {std::move(requests), std::move(rep_stream)};
+}
+
+template <typename RepT, typename ReqT>
+std::tuple<Stream_writer<ReqT>, Stream_future<RepT>> start_bidir_streaming_call(With_writer, Channel* channel, void* tag, Call_options options) {
+  assert(options.completion_queue);
+
+  auto call = channel->create_call(tag, options);
+
+  auto writer = std::make_shared<easy_grpc::detail::Writer_state<ReqT>>(
+      options.stream_capacity, options.coalesce_writes);
+  Stream_promise<RepT> rep;
+  auto rep_stream = rep.get_future();
 
-  Stream_promise<ReqT> req;
-  auto call_session = new Bidir_streaming_call_session<RepT, ReqT>(call, req.get_future());  
+  auto session = new Bidir_streaming_call_session<RepT, ReqT>(std::move(call), writer, std::move(rep));
+  session->start(options);
 
-  return {std::move(req), call_session->rep_.get_future()};
+  return {Stream_writer<ReqT>(std::move(writer)), std::move(rep_stream)};
 }
 
 
@@ -16,6 +16,8 @@
 #define EASY_GRPC_CLIENT_UNSECURE_CHANNEL_INCLUDED_H
 
 #include "easy_grpc/client/channel.h"
+#include "easy_grpc/channel_args.h"
+#include "easy_grpc/compression.h"
 
 namespace easy_grpc {
 namespace client {
@@ -28,6 +30,14 @@ class Unsecure_channel : public Channel {
   Unsecure_channel& operator=(const Unsecure_channel&) = delete;
 
   Unsecure_channel(const std::string& addr, Completion_queue* default_pool);
+
+  Unsecure_channel(const std::string& addr, Completion_queue* default_pool,
+                   const Channel_args& args);
+
+  // Compresses the requests of every call made on the channel, unless the
+  // call's options say otherwise.
+  Unsecure_channel(const std::string& addr, Completion_queue* default_pool,
+                   const Compression_options& compression);
 };
 }  // namespace client
 }  // namespace easy_grpc
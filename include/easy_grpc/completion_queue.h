@@ -22,7 +22,7 @@
 #include <bitset>
 
 namespace easy_grpc {
-// A completion queue, with a matching thread that consumes from it.
+// A completion queue, with a matching set of threads that consume from it.
 
 struct Completion_tag {
   void* data;
@@ -32,13 +32,18 @@ private:
   Completion_tag(void* d) : data(d) {}
 };
 
-class Completion_callback {
+// Aligned so that the low 4 bits of its address are free to carry the
+// completion's flags, even when it is a member of another object.
+class alignas(16) Completion_callback {
   public:
   virtual ~Completion_callback() {}
 
   // TODO: replace bool with an enum
   virtual bool exec(bool success, std::bitset<4> flags) noexcept = 0;
 
+  // Invoked once exec() has returned true.
+  virtual void release() noexcept { delete this; }
+
   Completion_tag completion_tag(std::bitset<4> flags = {}) {
     intptr_t tag_val = reinterpret_cast<intptr_t>(this);
     
@@ -51,14 +56,22 @@ class Completion_callback {
 class Completion_queue {
  public:
   Completion_queue();
+
+  // Creates a queue drained by thread_count worker threads. If cpu_set is not
+  // empty, worker i is pinned to cpu_set[i % cpu_set.size()] (Linux only).
+  explicit Completion_queue(std::size_t thread_count,
+                            std::vector<int> cpu_set = {});
   ~Completion_queue();
 
   grpc_completion_queue* handle() { return handle_; }
 
-  
+  std::size_t thread_count() const { return threads_.size(); }
+
  private:
   void worker_main();
-  std::thread thread_;
+  void shutdown_();
+
+  std::vector<std::thread> threads_;
   grpc_completion_queue* handle_;
 };
 
@@ -0,0 +1,35 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_COMPRESSION_H_INCLUDED
+#define EASY_GRPC_COMPRESSION_H_INCLUDED
+
+#include "grpc/compression.h"
+
+#include <optional>
+
+namespace easy_grpc {
+
+// Default compression of a channel or server.
+//
+// The algorithm is what outgoing messages are compressed with. The level only
+// applies to servers, which pick the best algorithm for it among the ones the
+// client accepts. Unset fields leave grpc's default (no compression) alone.
+struct Compression_options {
+  std::optional<grpc_compression_algorithm> algorithm;
+  std::optional<grpc_compression_level> level;
+};
+
+}  // namespace easy_grpc
+#endif
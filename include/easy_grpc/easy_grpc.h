@@ -16,14 +16,28 @@
 #define EASY_GRPC_LIB_H_INCLUDED
 
 #include "easy_grpc/config.h"
+#include "easy_grpc/bytes.h"
+#include "easy_grpc/channel_args.h"
 
 #include "easy_grpc/completion_queue.h"
+#include "easy_grpc/compression.h"
 #include "easy_grpc/environment.h"
 #include "easy_grpc/error.h"
-
+#include "easy_grpc/serialized.h"
+#include "easy_grpc/stream_writer.h"
+#include "easy_grpc/worker_pool.h"
+
+#include "easy_grpc/client/balanced_channel.h"
+#include "easy_grpc/client/balancing_policy.h"
+#include "easy_grpc/client/channel_pool.h"
+#include "easy_grpc/client/hedging.h"
 #include "easy_grpc/client/method_stub.h"
+#include "easy_grpc/client/retry_policy.h"
 #include "easy_grpc/client/unsecure_channel.h"
 
+#include "easy_grpc/server/call_context.h"
+#include "easy_grpc/server/concurrency_limit.h"
+#include "easy_grpc/server/concurrency_limit_feature.h"
 #include "easy_grpc/server/server.h"
 #include "easy_grpc/server/service.h"
 #include "easy_grpc/server/service_config.h"
@@ -0,0 +1,216 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_EXT_PROTOBUF_BYTE_BUFFER_STREAM_INCLUDED_H
+#define EASY_GRPC_EXT_PROTOBUF_BYTE_BUFFER_STREAM_INCLUDED_H
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include "grpc/byte_buffer_reader.h"
+#include "grpc/grpc.h"
+#include "grpc/slice.h"
+
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace easy_grpc {
+
+namespace detail {
+// Fixed-size blocks backing serialized messages. Blocks come back to the
+// pool once grpc drops the last reference to the slice wrapping them.
+class Slice_block_pool {
+ public:
+  static constexpr std::size_t block_size = 64 * 1024;
+
+  // Free blocks kept around beyond this are handed back to the allocator.
+  static constexpr std::size_t max_retained = 128;
+
+  static Slice_block_pool& instance() {
+    // Leaked on purpose: grpc may release slices during static destruction.
+    static auto pool = new Slice_block_pool();
+    return *pool;
+  }
+
+  void* acquire() {
+    {
+      std::lock_guard l(mtx_);
+      if (!free_.empty()) {
+        auto block = free_.back();
+        free_.pop_back();
+        return block;
+      }
+    }
+    return ::operator new(block_size);
+  }
+
+  void release(void* block) {
+    {
+      std::lock_guard l(mtx_);
+      if (free_.size() < max_retained) {
+        free_.push_back(block);
+        return;
+      }
+    }
+    ::operator delete(block);
+  }
+
+  // Wraps the first used bytes of block in a slice that owns the block.
+  grpc_slice make_slice(void* block, std::size_t used) {
+    return grpc_slice_new_with_user_data(block, used, &release_block, block);
+  }
+
+ private:
+  Slice_block_pool() = default;
+
+  static void release_block(void* block) { instance().release(block); }
+
+  std::mutex mtx_;
+  std::vector<void*> free_;
+};
+}  // namespace detail
+
+// Lets protobuf parse straight out of the slices of a byte buffer, instead
+// of having to flatten them first.
+class Byte_buffer_input_stream final
+    : public ::google::protobuf::io::ZeroCopyInputStream {
+ public:
+  explicit Byte_buffer_input_stream(grpc_byte_buffer* buffer) {
+    ok_ = grpc_byte_buffer_reader_init(&reader_, buffer) != 0;
+  }
+
+  ~Byte_buffer_input_stream() {
+    if (ok_) {
+      grpc_slice_unref(slice_);
+      grpc_byte_buffer_reader_destroy(&reader_);
+    }
+  }
+
+  bool Next(const void** data, int* size) override {
+    if (!ok_) {
+      return false;
+    }
+
+    if (backed_up_ > 0) {
+      auto slice_size = GRPC_SLICE_LENGTH(slice_);
+      *data = GRPC_SLICE_START_PTR(slice_) + slice_size - backed_up_;
+      *size = static_cast<int>(backed_up_);
+      backed_up_ = 0;
+      return true;
+    }
+
+    grpc_slice_unref(slice_);
+    if (!grpc_byte_buffer_reader_next(&reader_, &slice_)) {
+      slice_ = grpc_empty_slice();
+      return false;
+    }
+
+    *data = GRPC_SLICE_START_PTR(slice_);
+    *size = static_cast<int>(GRPC_SLICE_LENGTH(slice_));
+    byte_count_ += *size;
+    return true;
+  }
+
+  void BackUp(int count) override {
+    assert(count >= 0 && static_cast<std::size_t>(count) <= GRPC_SLICE_LENGTH(slice_));
+    backed_up_ = count;
+  }
+
+  bool Skip(int count) override {
+    const void* data;
+    int size;
+    while (Next(&data, &size)) {
+      if (size >= count) {
+        BackUp(size - count);
+        return true;
+      }
+      count -= size;
+    }
+    return false;
+  }
+
+  std::int64_t ByteCount() const override { return byte_count_ - backed_up_; }
+
+ private:
+  grpc_byte_buffer_reader reader_;
+  grpc_slice slice_ = grpc_empty_slice();
+  std::int64_t byte_count_ = 0;
+  std::int64_t backed_up_ = 0;
+  bool ok_ = false;
+};
+
+// Serializes into a chain of pooled fixed-size slices, so that large
+// messages never need a single large allocation.
+class Slice_chain_output_stream final
+    : public ::google::protobuf::io::ZeroCopyOutputStream {
+  using Pool = detail::Slice_block_pool;
+
+ public:
+  Slice_chain_output_stream() = default;
+
+  ~Slice_chain_output_stream() {
+    for (auto block : blocks_) {
+      Pool::instance().release(block);
+    }
+  }
+
+  bool Next(void** data, int* size) override {
+    auto block = Pool::instance().acquire();
+    blocks_.push_back(block);
+
+    last_block_used_ = Pool::block_size;
+    byte_count_ += Pool::block_size;
+
+    *data = block;
+    *size = static_cast<int>(Pool::block_size);
+    return true;
+  }
+
+  void BackUp(int count) override {
+    assert(!blocks_.empty() && static_cast<std::size_t>(count) <= last_block_used_);
+    last_block_used_ -= count;
+    byte_count_ -= count;
+  }
+
+  std::int64_t ByteCount() const override { return byte_count_; }
+
+  // Hands the written data over to a new byte buffer.
+  grpc_byte_buffer* release_buffer() {
+    auto& pool = Pool::instance();
+
+    std::vector<grpc_slice> slices;
+    slices.reserve(blocks_.size());
+    for (std::size_t i = 0; i < blocks_.size(); ++i) {
+      bool last = i + 1 == blocks_.size();
+      slices.push_back(pool.make_slice(blocks_[i], last ? last_block_used_ : Pool::block_size));
+    }
+    blocks_.clear();
+
+    auto result = grpc_raw_byte_buffer_create(slices.data(), slices.size());
+    for (auto& s : slices) {
+      grpc_slice_unref(s);
+    }
+    return result;
+  }
+
+ private:
+  std::vector<void*> blocks_;
+  std::size_t last_block_used_ = 0;
+  std::int64_t byte_count_ = 0;
+};
+}  // namespace easy_grpc
+
+#endif
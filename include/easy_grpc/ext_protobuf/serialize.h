@@ -15,38 +15,85 @@
 #ifndef EASY_GRPC_EXT_PROTOBUF_SERIALIZE_INCLUDED_H
 #define EASY_GRPC_EXT_PROTOBUF_SERIALIZE_INCLUDED_H
 
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/message.h>
+#include "easy_grpc/error.h"
+#include "easy_grpc/ext_protobuf/byte_buffer_stream.h"
 #include "easy_grpc/serialize.h"
 
+#include <cstddef>
+
 namespace easy_grpc {
 
+// Arena backing the messages of a single call. The first block is part of
+// the object, so a reset arena can serve typical calls without allocating.
+class Call_arena {
+ public:
+  static constexpr std::size_t initial_block_size = 8 * 1024;
+
+  Call_arena() : arena_(initial_block_, initial_block_size) {}
+
+  ::google::protobuf::Arena* get() { return &arena_; }
+  void reset() { arena_.Reset(); }
+
+ private:
+  alignas(std::max_align_t) char initial_block_[initial_block_size];
+  ::google::protobuf::Arena arena_;
+};
+
 template <typename T>
 struct Serializer<
     T,
     std::enable_if_t<std::is_base_of_v<::google::protobuf::MessageLite, T>>> {
   static grpc_byte_buffer* serialize(const T& msg) {
-    auto msg_size = msg.ByteSize();
-    auto slice = grpc_slice_malloc(msg_size);
+    auto msg_size = msg.ByteSizeLong();
+
+    if (msg_size <= detail::Slice_block_pool::block_size) {
+      auto slice = grpc_slice_malloc(msg_size);
+      msg.SerializeWithCachedSizesToArray(GRPC_SLICE_START_PTR(slice));
+
+      auto result = grpc_raw_byte_buffer_create(&slice, 1);
+      grpc_slice_unref(slice);
+      return result;
+    }
 
-    msg.SerializeWithCachedSizesToArray(GRPC_SLICE_START_PTR(slice));
+    Slice_chain_output_stream stream;
+    {
+      ::google::protobuf::io::CodedOutputStream coded(&stream);
+      msg.SerializeWithCachedSizes(&coded);
+    }
+    return stream.release_buffer();
+  }
+
+  using arena_type = Call_arena;
+
+  static T* create(arena_type& arena) {
+    return ::google::protobuf::Arena::CreateMessage<T>(arena.get());
+  }
 
-    return grpc_raw_byte_buffer_create(&slice, 1);
+  // Both throw an INVALID_ARGUMENT Rpc_error if data is not a valid
+  // encoding of T, like a truncated one.
+  static T* deserialize(grpc_byte_buffer* data, arena_type& arena) {
+    Byte_buffer_input_stream stream(data);
+
+    auto result = create(arena);
+    if (!result->ParseFromZeroCopyStream(&stream)) {
+      throw error::invalid_argument("failed to parse the message");
+    }
+
+    return result;
   }
 
   static T deserialize(grpc_byte_buffer* data) {
     assert(data->type == GRPC_BB_RAW);
 
-    // TODO: be smarter about this...
-    grpc_byte_buffer_reader reader;
-    grpc_byte_buffer_reader_init(&reader, data);
-    auto slice = grpc_byte_buffer_reader_readall(&reader);
+    Byte_buffer_input_stream stream(data);
 
     T result;
-
-    result.ParseFromArray(GRPC_SLICE_START_PTR(slice),
-                          GRPC_SLICE_LENGTH(slice));
-    grpc_slice_unref(slice);
-    grpc_byte_buffer_reader_destroy(&reader);
+    if (!result.ParseFromZeroCopyStream(&stream)) {
+      throw error::invalid_argument("failed to parse the message");
+    }
 
     return result;
   }
@@ -0,0 +1,84 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_MPSC_QUEUE_INCLUDED_H
+#define EASY_GRPC_MPSC_QUEUE_INCLUDED_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace easy_grpc {
+
+namespace detail {
+
+// Unbounded multi-producer, single-consumer queue.
+//
+// push() is wait-free and can be called from any thread. pop() and empty()
+// must only ever be called by one thread at a time. A push that is still in
+// progress can hide the messages pushed after it from the consumer until it
+// is done.
+template <typename T>
+class Mpsc_queue {
+  struct Node {
+    std::atomic<Node*> next = nullptr;
+    std::optional<T> value;
+  };
+
+ public:
+  Mpsc_queue() : head_(new Node), tail_(head_.load()) {}
+
+  Mpsc_queue(const Mpsc_queue&) = delete;
+  Mpsc_queue& operator=(const Mpsc_queue&) = delete;
+
+  ~Mpsc_queue() {
+    while (pop()) {
+    }
+    delete tail_;
+  }
+
+  void push(T val) {
+    auto node = new Node;
+    node->value.emplace(std::move(val));
+
+    auto prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  std::optional<T> pop() {
+    auto next = tail_->next.load(std::memory_order_acquire);
+    if (!next) {
+      return std::nullopt;
+    }
+
+    // next becomes the new stub.
+    T result = std::move(*next->value);
+    next->value.reset();
+    delete tail_;
+    tail_ = next;
+    return std::optional<T>(std::move(result));
+  }
+
+  bool empty() const {
+    return tail_->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  std::atomic<Node*> head_;
+  Node* tail_;
+};
+}  // namespace detail
+}  // namespace easy_grpc
+
+#endif
@@ -18,14 +18,19 @@
 #include "grpc/byte_buffer_reader.h"
 #include "grpc/grpc.h"
 
+#include <type_traits>
+#include <utility>
+
 namespace easy_grpc {
 
 template <typename T, typename E = void>
 struct Serializer;
 
+// Rvalues are forwarded, so serializers that can take ownership of the
+// data instead of copying it get the chance to.
 template <typename T>
-grpc_byte_buffer* serialize(const T& data) {
-  return Serializer<T>::serialize(data);
+grpc_byte_buffer* serialize(T&& data) {
+  return Serializer<std::decay_t<T>>::serialize(std::forward<T>(data));
 }
 
 template <typename T>
@@ -0,0 +1,74 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERIALIZED_INCLUDED_H
+#define EASY_GRPC_SERIALIZED_INCLUDED_H
+
+#include "easy_grpc/serialize.h"
+
+#include <memory>
+
+namespace easy_grpc {
+
+// A message that is encoded once, and can then be sent any number of times.
+//
+// Copies share the same encoded payload, and sending one only adds a
+// reference to its slices. This is meant for fanning out the same message
+// to many streams:
+//
+// Stream_future<Serialized<Update>> Subscribe(Request);
+template <typename T>
+class Serialized {
+ public:
+  using value_type = T;
+
+  Serialized() = default;
+  explicit Serialized(const T& msg)
+      : buffer_(Serializer<T>::serialize(msg), grpc_byte_buffer_destroy) {}
+
+  // Decodes the message back.
+  T get() const { return Serializer<T>::deserialize(buffer_.get()); }
+
+  // nullptr if default-constructed.
+  grpc_byte_buffer* buffer() const { return buffer_.get(); }
+
+  std::size_t size() const {
+    return buffer_ ? grpc_byte_buffer_length(buffer_.get()) : 0;
+  }
+
+ private:
+  explicit Serialized(grpc_byte_buffer* buffer)
+      : buffer_(buffer, grpc_byte_buffer_destroy) {}
+
+  std::shared_ptr<grpc_byte_buffer> buffer_;
+
+  friend struct Serializer<Serialized<T>>;
+};
+
+template <typename T>
+struct Serializer<Serialized<T>> {
+  static grpc_byte_buffer* serialize(const Serialized<T>& data) {
+    if (!data.buffer()) {
+      return grpc_raw_byte_buffer_create(nullptr, 0);
+    }
+    return grpc_byte_buffer_copy(data.buffer());
+  }
+
+  static Serialized<T> deserialize(grpc_byte_buffer* data) {
+    return Serialized<T>(grpc_byte_buffer_copy(data));
+  }
+};
+}  // namespace easy_grpc
+
+#endif
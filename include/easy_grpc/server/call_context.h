@@ -0,0 +1,129 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_CALL_CONTEXT_H_INCLUDED
+#define EASY_GRPC_SERVER_CALL_CONTEXT_H_INCLUDED
+
+#include "easy_grpc/config.h"
+
+#include "grpc/support/time.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace easy_grpc {
+namespace server {
+
+namespace detail {
+// Shared between a call's handler and the Call_contexts handed out for it,
+// which can outlive the call.
+class Call_state {
+ public:
+  explicit Call_state(gpr_timespec deadline) {
+    deadline = gpr_convert_clock_type(deadline, GPR_CLOCK_REALTIME);
+    if (gpr_time_cmp(deadline, gpr_inf_future(GPR_CLOCK_REALTIME)) == 0) {
+      deadline_ = std::chrono::system_clock::time_point::max();
+    } else {
+      deadline_ = std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::seconds(deadline.tv_sec) +
+              std::chrono::nanoseconds(deadline.tv_nsec)));
+    }
+  }
+
+  std::chrono::system_clock::time_point deadline() const { return deadline_; }
+
+  bool cancelled() const { return cancelled_; }
+
+  Future<bool> on_cancel() {
+    Promise<bool> prom;
+    auto result = prom.get_future();
+
+    std::unique_lock l(mtx_);
+    if (!done_) {
+      cancel_proms_.push_back(std::move(prom));
+    } else {
+      l.unlock();
+      prom.set_value(cancelled_.load());
+    }
+    return result;
+  }
+
+  // The call is over, cancellation promises learn how it ended.
+  void finish(bool cancelled) {
+    std::vector<Promise<bool>> proms;
+    {
+      std::lock_guard l(mtx_);
+      cancelled_ = cancelled;
+      done_ = true;
+      proms = std::move(cancel_proms_);
+      cancel_proms_.clear();
+    }
+
+    for (auto& p : proms) {
+      p.set_value(cancelled);
+    }
+  }
+
+  // A call torn down without its close ever coming in did not complete.
+  ~Call_state() {
+    for (auto& p : cancel_proms_) {
+      p.set_value(true);
+    }
+  }
+
+ private:
+  std::chrono::system_clock::time_point deadline_;
+  std::atomic<bool> cancelled_ = false;
+
+  std::mutex mtx_;
+  bool done_ = false;
+  std::vector<Promise<bool>> cancel_proms_;
+};
+}  // namespace detail
+
+// What a handler can know about the call it is serving. Handlers receive it
+// by adding a const Call_context& as their last argument:
+//
+// Future<Reply> Method(Request req, const Call_context& ctx);
+//
+// Copies refer to the same call, and remain valid after it is over.
+class Call_context {
+ public:
+  explicit Call_context(std::shared_ptr<detail::Call_state> state)
+      : state_(std::move(state)) {}
+
+  // Infinite if the client did not set one.
+  std::chrono::system_clock::time_point deadline() const {
+    return state_->deadline();
+  }
+
+  // Becomes true as soon as the call is cancelled, be it by the client, by
+  // its deadline expiring, or by the connection going away.
+  bool cancelled() const { return state_->cancelled(); }
+
+  // Resolves as soon as the call is over: with true if it was cancelled,
+  // and with false once it completes normally.
+  Future<bool> on_cancel() const { return state_->on_cancel(); }
+
+ private:
+  std::shared_ptr<detail::Call_state> state_;
+};
+
+}  // namespace server
+}  // namespace easy_grpc
+#endif
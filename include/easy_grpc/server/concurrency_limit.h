@@ -0,0 +1,137 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_CONCURRENCY_LIMIT_H_INCLUDED
+#define EASY_GRPC_SERVER_CONCURRENCY_LIMIT_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace easy_grpc {
+namespace server {
+
+// Caps how many calls are handled at the same time. Calls that arrive while
+// the limit is reached wait in a bounded FIFO for a slot to free up, and are
+// rejected with RESOURCE_EXHAUSTED once that is full as well.
+//
+// A limiter is attached to methods through Method_options. Methods sharing the
+// same limiter share its slots.
+class Concurrency_limiter {
+ public:
+  explicit Concurrency_limiter(std::size_t max_queued = 0);
+  virtual ~Concurrency_limiter() {}
+
+  // How many calls may currently be in flight.
+  virtual std::size_t limit() const = 0;
+
+  std::size_t in_flight() const;
+  std::size_t queued() const;
+
+  // Calls turned away because the queue was full.
+  std::uint64_t rejected() const;
+
+  // Takes a slot for a new call, if one is free.
+  bool try_acquire();
+
+  // Queues start, to be invoked once the call gets a slot. If one freed up in
+  // the meantime, start is invoked right away. Returns false if the queue is
+  // full, in which case the call must be rejected.
+  bool enqueue(std::function<void()> start);
+
+  // Gives back the slot of a call that took latency to complete, starting
+  // queued calls if there is room for them.
+  void release(std::chrono::steady_clock::duration latency);
+
+ protected:
+  // Invoked for every completed call, before its slot is given back.
+  virtual void on_call_done(std::chrono::steady_clock::duration) {}
+
+ private:
+  // Noncopyable
+  Concurrency_limiter(const Concurrency_limiter&) = delete;
+  Concurrency_limiter& operator=(const Concurrency_limiter&) = delete;
+
+  mutable std::mutex mtx_;
+  std::size_t in_flight_ = 0;
+  std::size_t max_queued_;
+  std::deque<std::function<void()>> queue_;
+  std::uint64_t rejected_ = 0;
+};
+
+// A fixed limit.
+class Concurrency_limit : public Concurrency_limiter {
+ public:
+  explicit Concurrency_limit(std::size_t max_in_flight,
+                             std::size_t max_queued = 0);
+
+  std::size_t limit() const override { return max_in_flight_; }
+
+ private:
+  std::size_t max_in_flight_;
+};
+
+struct Adaptive_limit_options {
+  std::size_t initial_limit = 16;
+  std::size_t min_limit = 1;
+  std::size_t max_limit = 1024;
+
+  // Calls that take longer than this, from the moment they get a slot to the
+  // moment they are done, are taken as a sign of overload.
+  std::chrono::steady_clock::duration latency_threshold =
+      std::chrono::milliseconds(100);
+
+  // The limit is multiplied by this on overload.
+  double backoff_ratio = 0.9;
+
+  // Calls that can wait for a slot.
+  std::size_t max_queued = 0;
+};
+
+// A limit that follows what the method can currently sustain (AIMD).
+//
+// Every call completed under the latency threshold while the limit is being
+// put to use grows it by 1/limit, so roughly by one per limit's worth of
+// calls. A call over the threshold cuts it by backoff_ratio. Only calls that
+// got their slot after the previous cut can cause another one, since the ones
+// before it were admitted under the old limit.
+class Adaptive_concurrency_limit : public Concurrency_limiter {
+ public:
+  explicit Adaptive_concurrency_limit(Adaptive_limit_options options = {});
+
+  std::size_t limit() const override { return limit_; }
+
+  // How many times the limit was cut.
+  std::uint64_t backoffs() const;
+
+ protected:
+  void on_call_done(std::chrono::steady_clock::duration latency) override;
+
+ private:
+  Adaptive_limit_options options_;
+  std::atomic<std::size_t> limit_;
+
+  mutable std::mutex estimate_mtx_;
+  double estimate_;
+  std::chrono::steady_clock::time_point last_backoff_;
+  std::uint64_t backoffs_ = 0;
+};
+
+}  // namespace server
+}  // namespace easy_grpc
+#endif
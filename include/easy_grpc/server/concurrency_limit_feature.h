@@ -0,0 +1,54 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_CONCURRENCY_LIMIT_FEATURE_H_INCLUDED
+#define EASY_GRPC_SERVER_CONCURRENCY_LIMIT_FEATURE_H_INCLUDED
+
+#include "easy_grpc/server/concurrency_limit.h"
+#include "easy_grpc/server/server.h"
+
+#include <functional>
+#include <memory>
+
+namespace easy_grpc {
+namespace server {
+
+// Puts a concurrency limit on the methods of every service added to the
+// config so far. Methods that already have one keep it.
+class Concurrency_limit_feature : public Feature {
+ public:
+  enum class Scope {
+    method,   // Each method gets its own limiter.
+    service,  // The methods of a service share a limiter.
+  };
+
+  using Factory = std::function<std::shared_ptr<Concurrency_limiter>()>;
+
+  Concurrency_limit_feature(Factory make_limiter, Scope scope = Scope::method);
+
+  // Fixed limits.
+  explicit Concurrency_limit_feature(std::size_t max_in_flight,
+                                     std::size_t max_queued = 0,
+                                     Scope scope = Scope::method);
+
+  void add_to_config(Config& cfg) override;
+
+ private:
+  Factory make_limiter_;
+  Scope scope_;
+};
+
+}  // namespace server
+}  // namespace easy_grpc
+#endif
@@ -0,0 +1,62 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_METHOD_OPTIONS_H_INCLUDED
+#define EASY_GRPC_SERVER_METHOD_OPTIONS_H_INCLUDED
+
+#include "easy_grpc/server/concurrency_limit.h"
+#include "easy_grpc/worker_pool.h"
+
+#include "grpc/compression.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace easy_grpc {
+namespace server {
+
+struct Method_options {
+  // Number of calls requested from grpc ahead of time on each of the method's
+  // queues. Raising this lets bursts of calls be accepted without waiting for
+  // the listener to be re-armed between each of them. It is also how many
+  // finished call handlers each queue keeps around for reuse.
+  std::size_t listener_depth = 1;
+
+  // If set, synchronous unary handlers run on this pool instead of the
+  // completion queue's threads. Calls are rejected with RESOURCE_EXHAUSTED
+  // while the pool's queue is full.
+  std::shared_ptr<Worker_pool> worker_pool;
+
+  // How many messages the Stream_writer handed to a streaming handler holds
+  // before ready() stops resolving immediately.
+  std::size_t stream_capacity = 16;
+
+  // Lets grpc batch streamed replies that are queued back to back into fewer
+  // frames and syscalls, instead of flushing each of them on its own.
+  bool coalesce_writes = false;
+
+  // If set, calls beyond the limiter's limit are queued or rejected with
+  // RESOURCE_EXHAUSTED instead of being handled right away. Methods given the
+  // same limiter share it.
+  std::shared_ptr<Concurrency_limiter> concurrency_limit;
+
+  // Compresses the method's replies at this level instead of the server's
+  // default. grpc picks the algorithm among the ones the client accepts.
+  std::optional<grpc_compression_level> compression_level;
+};
+
+}  // namespace server
+}  // namespace easy_grpc
+#endif
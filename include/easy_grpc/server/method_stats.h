@@ -0,0 +1,49 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_METHOD_STATS_H_INCLUDED
+#define EASY_GRPC_SERVER_METHOD_STATS_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+
+namespace easy_grpc {
+namespace server {
+
+// Counters maintained by the server for each of its methods.
+struct Method_stats {
+  // Call handlers created from the heap. Once the server has warmed up, this
+  // should stop increasing, as finished handlers are recycled.
+  std::atomic<std::uint64_t> handlers_allocated = 0;
+
+  // Call handlers taken from the recycling pool.
+  std::atomic<std::uint64_t> handlers_reused = 0;
+
+  // Finished call handlers deleted because the pool already held enough.
+  std::atomic<std::uint64_t> handlers_freed = 0;
+
+  // Calls that have been received, and whose handler is not done yet.
+  std::atomic<std::uint64_t> calls_in_flight = 0;
+
+  // Calls whose deadline had already passed by the time they were picked up.
+  // These are failed with DEADLINE_EXCEEDED without reaching the handler.
+  std::atomic<std::uint64_t> calls_expired = 0;
+
+  // Calls rejected with RESOURCE_EXHAUSTED by the method's concurrency limit.
+  std::atomic<std::uint64_t> calls_shed = 0;
+};
+
+}  // namespace server
+}  // namespace easy_grpc
+#endif
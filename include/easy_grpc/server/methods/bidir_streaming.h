@@ -16,14 +16,17 @@
 #define EASY_GRPC_SERVER_METHOD_BIDIR_STREAMING_H_INCLUDED
 
 #include "easy_grpc/config.h"
+#include "easy_grpc/error.h"
 #include "easy_grpc/server/methods/method.h"
 
 #include "easy_grpc/function_traits.h"
 #include "easy_grpc/serialize.h"
+#include "easy_grpc/stream_writer.h"
 #include "easy_grpc/server/methods/call_handler.h"
 
 #include <cassert>
-#include <queue>
+#include <memory>
+#include <tuple>
 
 namespace easy_grpc {
 namespace server {
@@ -31,42 +34,73 @@ namespace detail {
 
 
 template <typename ReqT, typename RepT, bool sync>
-class Bidir_streaming_call_handler : public Call_handler {
+class Bidir_streaming_call_handler : public Call_handler, public easy_grpc::detail::Message_sink {
+  using writer_type = easy_grpc::detail::Writer_state<RepT>;
+
   Stream_promise<ReqT> reader_prom_;
   grpc_byte_buffer* payload_ = nullptr;
   
-  std::mutex mtx_;
-  bool finished_ = false;
-  bool ready_to_send_ = false;
-  std::queue<grpc_op> pending_ops_;
+  std::shared_ptr<writer_type> writer_;
+  bool confirming_end_ = false;
 
 public:
   static constexpr bool immediate_payload = false;
 
   Bidir_streaming_call_handler() = default;
-  ~Bidir_streaming_call_handler() {}
+  ~Bidir_streaming_call_handler() {
+    if(writer_) {
+      writer_->detach();
+    }
+  }
+
+  void reset() {
+    // Fails the previous reader if the call ended before it was completed.
+    Stream_promise<ReqT> previous_reader(std::move(reader_prom_));
+    confirming_end_ = false;
+    if(writer_) {
+      writer_->detach();
+      writer_.reset();
+    }
+    Call_handler::reset();
+  }
 
   template<typename CbT>
-  void perform(const CbT& cb) {      
-    auto reply_fut = cb(reader_prom_.get_future());
-
-    reply_fut.for_each([this, cb](RepT rep) mutable {
-      push(rep);
-    }).finally([this](expected<void> status){
-      if(status.has_value()) {
-          finish();
-        }
-        else {
-          fail(status.error());
-        }
-    });
+  void perform(const CbT& cb, const Method_options& options) {      
+    constexpr bool writer_mode = takes_writer_v<CbT>;
+    writer_ = std::make_shared<writer_type>(
+        writer_mode ? options.stream_capacity : 0, options.coalesce_writes);
+
+    // Stops the stream as soon as the client goes away.
+    watch_close();
+
+    try {
+      if constexpr(writer_mode) {
+        // An lvalue, so that handlers can take the writer by reference.
+        Stream_writer<RepT> writer(writer_);
+        invoke_handler(cb, state_, reader_prom_.get_future(), writer);
+      }
+      else {
+        invoke_handler(cb, state_, reader_prom_.get_future()).for_each([w = writer_](RepT rep) {
+          w->push(std::move(rep));
+        }).finally([w = writer_](expected<void> status){
+          if(status.has_value()) {
+            w->complete();
+          }
+          else {
+            w->fail(status.error());
+          }
+        });
+      }
+    } catch(...) {
+      writer_->fail(std::current_exception());
+    }
 
     {
       std::array<grpc_op, 1> ops;
       op_send_metadata(ops[0]);
 
       auto call_status =
-          grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(8).data, nullptr);
+          start_batch(ops.data(), ops.size(), completion_tag(8).data);
       
       if (call_status != GRPC_CALL_OK) {
         std::cerr << grpc_call_error_to_string(call_status) << "\n";
@@ -75,104 +109,68 @@ public:
     }
   }
 
-  void send_server_end() {
-    std::array<grpc_op, 2> ops;
-
-    op_recv_close(ops[0]);
-    op_send_status(ops[1]);
-
-    auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(4).data, nullptr);
-
-    if(status != GRPC_CALL_OK) {
-      std::cerr << grpc_call_error_to_string(status) << "\n";
-      assert(false);
-    }
-  }
-
-
-  void push(const RepT& val) {
-    std::lock_guard l(mtx_);
+  void write(grpc_byte_buffer* buffer, bool buffered) override {
     grpc_op op;
-    op_send_message(op, serialize(val));
-
-    pending_ops_.push(op);
-
-    flush_();
-  }
-
-   void finish() {
-    std::lock_guard l(mtx_);
-
-    finished_ = true;
-
-    if(ready_to_send_) {
-      send_server_end();
+    op_send_message(op, buffer);
+    if(buffered) {
+      op.flags = GRPC_WRITE_BUFFER_HINT;
     }
-  }
-
-  void fail(std::exception_ptr) {
     
-    std::lock_guard l(mtx_);
-
-    std::array<grpc_op, 2> ops;
-
-    op_send_status(ops[0]);
-    op_recv_close(ops[1]);
-
     auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag().data, nullptr);
+      start_batch(&op, 1, completion_tag(2).data);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
-      assert(false);
     }
+    assert(status == GRPC_CALL_OK);
+    
+    grpc_byte_buffer_destroy(buffer);
   }
 
-   void flush_() {
-    if(!ready_to_send_) {
-      return ;
+  void close(std::exception_ptr error) override {
+    grpc_status_code code = GRPC_STATUS_OK;
+    grpc_slice details = grpc_empty_slice();
+    if(error) {
+      std::tie(code, details) = get_error_details(error);
     }
 
-    ready_to_send_ = false;
-
-    auto op = pending_ops_.front();
-    pending_ops_.pop();
+    // The close itself is received through watch_close().
+    std::array<grpc_op, 1> ops;
+    op_send_status(ops[0], code, &details);
 
-    assert(op.op == GRPC_OP_SEND_MESSAGE);
-    
     auto status =
-      grpc_call_start_batch(call_, &op, 1, completion_tag(2).data, nullptr);
+      start_batch(ops.data(), ops.size(), completion_tag(4).data);
+    grpc_slice_unref(details);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
+      assert(false);
     }
-    assert(status == GRPC_CALL_OK);
-    
-    grpc_byte_buffer_destroy(op.data.send_message.send_message);
   }
 
-  bool exec(bool, std::bitset<4> flags) noexcept override {
-    std::unique_lock l(mtx_);
+  void on_cancelled() override {
+    writer_->cancel();
+  }
 
+  bool exec(bool ok, std::bitset<4> flags) noexcept override {
     bool recv_op = flags.test(0);
     bool send_op = flags.test(1);
     bool closing = flags.test(2);
     bool handshake = flags.test(3);
 
     if(handshake) {
+      // The read loop must be over before the handler is released.
+      expect_end();
+
       // start sending
-      ready_to_send_ = true;
-      if(!pending_ops_.empty()) {
-        flush_();
-      }
+      writer_->attach(this, ok);
 
       // start receiving
       std::array<grpc_op, 1> ops;
         op_recv_message(ops[0], &payload_);
         
         auto call_status =
-            grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(1).data, nullptr);
+            start_batch(ops.data(), ops.size(), completion_tag(1).data);
         if (call_status != GRPC_CALL_OK) {
           assert(false);
         }
@@ -180,13 +178,7 @@ public:
 
     
     if(send_op) {
-      ready_to_send_ = true;
-      if(!pending_ops_.empty()) {
-        flush_();
-      }
-      else if(finished_) {
-        send_server_end();
-      }
+      writer_->on_written(ok);
     }
 
     if(recv_op) {
@@ -194,26 +186,57 @@ public:
         auto raw_data = payload_;
           payload_ = nullptr;
 
+          // Don't re-arm the read until the message is delivered, to preserve
+          // ordering on multi-threaded queues.
+          try {
+            reader_prom_.push(deserialize<ReqT>(raw_data));
+            grpc_byte_buffer_destroy(raw_data);
+          } catch(...) {
+            grpc_byte_buffer_destroy(raw_data);
+
+            // Ends the call whatever the handler does, and stops reading.
+            auto error = std::current_exception();
+            reader_prom_.set_exception(error);
+            writer_->fail(error);
+            return end_reached();
+          }
+
           std::array<grpc_op, 1> ops;
           op_recv_message(ops[0], &payload_);
           
           auto call_status =
-              grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(1).data, nullptr);
+              start_batch(ops.data(), ops.size(), completion_tag(1).data);
           if (call_status != GRPC_CALL_OK) {
             assert(false);
           }
+      }
+      else if(!ok || state_->cancelled()) {
+        // The call died, rather than the client being done sending. Failing
+        // the requests stops the handler's pipelines that consume them.
+        reader_prom_.set_exception(std::make_exception_ptr(error::cancelled("call cancelled")));
+        return end_reached();
+      }
+      else if(!confirming_end_) {
+        // grpc reports a cancelled read just like the end of the requests.
+        // Reading once more gives the cancellation, if any, time to land.
+        confirming_end_ = true;
+
+        std::array<grpc_op, 1> ops;
+        op_recv_message(ops[0], &payload_);
 
-          l.unlock();
-          reader_prom_.push(deserialize<ReqT>(raw_data));
-          grpc_byte_buffer_destroy(raw_data);        
+        auto call_status =
+            start_batch(ops.data(), ops.size(), completion_tag(1).data);
+        if (call_status != GRPC_CALL_OK) {
+          assert(false);
+        }
       }
       else {
-        l.unlock();
         reader_prom_.complete();
+        return end_reached();
       }
     }
 
-    return closing;
+    return closing && end_reached();
   }
 };
 
@@ -19,15 +19,83 @@
 #include "easy_grpc/error.h"
 #include "easy_grpc/serialize.h"
 #include "easy_grpc/function_traits.h"
+#include "easy_grpc/server/call_context.h"
+#include "easy_grpc/server/method_options.h"
+#include "easy_grpc/server/methods/method_drain.h"
 
 #include "grpc/grpc.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <utility>
 
 namespace easy_grpc {
 namespace server {
 namespace detail {
 
+class Call_handler;
+
+// Whether a handler callback takes a Call_context as its last argument.
+template<typename CbT, typename Enable = void>
+struct Takes_context : public std::false_type {};
+
+template<typename CbT>
+struct Takes_context<CbT, std::enable_if_t<(function_traits<CbT>::arity > 0)>> {
+  using last_arg = typename function_traits<CbT>::template arg<function_traits<CbT>::arity - 1>::type;
+  static constexpr bool value = std::is_same_v<std::decay_t<last_arg>, Call_context>;
+};
+
+template<typename CbT>
+constexpr bool takes_context_v = Takes_context<CbT>::value;
+
+// Calls cb with args, followed by the call's context if cb wants it.
+template<typename CbT, typename... ArgsT>
+decltype(auto) invoke_handler(const CbT& cb, const std::shared_ptr<Call_state>& state, ArgsT&&... args) {
+  if constexpr(takes_context_v<CbT>) {
+    return cb(std::forward<ArgsT>(args)..., Call_context(state));
+  }
+  else {
+    return cb(std::forward<ArgsT>(args)...);
+  }
+}
+
+// Receives GRPC_OP_RECV_CLOSE_ON_SERVER on behalf of its handler, which
+// completes as soon as the call is cancelled.
+class Close_watcher : public Completion_callback {
+ public:
+  explicit Close_watcher(Call_handler* handler) : handler_(handler) {}
+
+  bool exec(bool, std::bitset<4>) noexcept override;
+  void release() noexcept override;
+
+ private:
+  Call_handler* handler_;
+};
+
+// Completes the only batch of a rejected call.
+class Rejection : public Completion_callback {
+ public:
+  explicit Rejection(Call_handler* handler) : handler_(handler) {}
+
+  bool exec(bool, std::bitset<4>) noexcept override { return true; }
+  void release() noexcept override;
+
+ private:
+  Call_handler* handler_;
+};
+
+class Handler_pool_base {
+ public:
+  virtual ~Handler_pool_base() {}
+
+  // Takes back a handler whose call is over.
+  virtual void recycle(Call_handler* handler) = 0;
+};
+
 // Unary calls are a bit special in the sense that we allow the handlers to be fully synchronous by returning
 // a RepT (as opposed to a Future<RepT>)
 class Call_handler : public Completion_callback {
@@ -46,6 +114,102 @@ class Call_handler : public Completion_callback {
     grpc_metadata_array_destroy(&server_metadata_);
   }
 
+  // Brings the handler back to its freshly constructed state, so that it can
+  // be handed to a new call.
+  void reset() {
+    if(call_) {
+      grpc_call_unref(call_);
+      call_ = nullptr;
+    }
+
+    // The metadata storage is kept around, grpc only grows it when needed.
+    request_metadata_.count = 0;
+    cancelled_ = false;
+    state_.reset();
+    ends_left_ = 1;
+    compression_level_.reset();
+  }
+
+  // Asks grpc for the end of the call right away, instead of along with the
+  // final status. The handler is then released once both are done.
+  void watch_close() {
+    state_ = std::make_shared<Call_state>(deadline_);
+    expect_end();
+
+    grpc_op op;
+    op_recv_close(op);
+    auto status =
+      start_batch(&op, 1, close_watcher_.completion_tag().data);
+
+    if(status != GRPC_CALL_OK) {
+      std::cerr << grpc_call_error_to_string(status) << "\n";
+    }
+    assert(status == GRPC_CALL_OK);
+  }
+
+  // Something besides the call's final batch, like a read loop, that must
+  // be over before the handler can be released.
+  void expect_end() {
+    ++ends_left_;
+  }
+
+  // To be called when the call's final batch, or anything passed to
+  // expect_end(), completes. Returns true if the handler can be released.
+  bool end_reached() {
+    return --ends_left_ == 0;
+  }
+
+  void close_received() {
+    state_->finish(cancelled_ != 0);
+    if(cancelled_) {
+      on_cancelled();
+    }
+  }
+
+  // The client went away while the close was being watched.
+  virtual void on_cancelled() {}
+
+  // Whether the call's deadline passed before it got to be handled.
+  bool expired() const {
+    return gpr_time_cmp(deadline_, gpr_now(deadline_.clock_type)) < 0;
+  }
+
+  // The call was given a slot by limiter, to be given back once it's over.
+  void hold_slot(std::shared_ptr<Concurrency_limiter> limiter) {
+    limiter_ = std::move(limiter);
+    admitted_at_ = std::chrono::steady_clock::now();
+  }
+
+  // Overrides the server's default compression for the call's replies.
+  void set_compression_level(std::optional<grpc_compression_level> level) {
+    compression_level_ = level;
+  }
+
+  // Ends the call with error, in place of perform(). The method's callback is
+  // never invoked, and the request is never deserialized.
+  void reject(std::exception_ptr error) {
+    send_failure(error, true, rejection_.completion_tag());
+  }
+
+  // Starts a batch on the call. Handlers from a pool go through their
+  // method's drain, which drops the batch if the server gave up on them.
+  grpc_call_error start_batch(const grpc_op* ops, std::size_t count, void* tag) {
+    if(drain_) {
+      return drain_->start_batch(call_, ops, count, tag);
+    }
+    return grpc_call_start_batch(call_, ops, count, tag, nullptr);
+  }
+
+  void release() noexcept override {
+    if(pool_) {
+      auto pool = std::move(pool_);
+      pool->recycle(this);
+    }
+    else {
+      delete this;
+    }
+  }
+
 
 void op_send_message(grpc_op& op, grpc_byte_buffer* buffer) {
   op.op = GRPC_OP_SEND_MESSAGE;
@@ -78,6 +242,10 @@ void op_send_metadata(grpc_op& op) {
   op.data.send_initial_metadata.count = server_metadata_.count;
   op.data.send_initial_metadata.metadata = server_metadata_.metadata;
   op.data.send_initial_metadata.maybe_compression_level.is_set = false;
+  if(compression_level_) {
+    op.data.send_initial_metadata.maybe_compression_level.is_set = true;
+    op.data.send_initial_metadata.maybe_compression_level.level = *compression_level_;
+  }
 }
 
 void op_recv_message(grpc_op& op, grpc_byte_buffer** payload) {
@@ -105,55 +273,92 @@ std::tuple<grpc_status_code, grpc_slice> get_error_details(std::exception_ptr er
 }
 
 template<typename RepT>
-void send_unary_response(const RepT& rep, bool with_metadata, std::bitset<4> flags) {
+void send_unary_response(RepT&& rep, bool with_metadata, std::bitset<4> flags) {
   std::array<grpc_op, 4> ops;
 
-  std::size_t ops_count = 3;
+  std::size_t ops_count = 2;
 
-  auto buffer = serialize(rep);
+  auto buffer = serialize(std::forward<RepT>(rep));
 
   op_send_message(ops[0], buffer);
   op_send_status(ops[1]);
-  op_recv_close(ops[2]);
+
+  if(!state_) {
+    op_recv_close(ops[ops_count++]);
+  }
 
   if(with_metadata) {
-    ++ops_count;
-    op_send_metadata(ops[3]);
+    op_send_metadata(ops[ops_count++]);
   }
 
   auto call_status =
-      grpc_call_start_batch(call_, ops.data(), ops_count, completion_tag(flags).data, nullptr);
+      start_batch(ops.data(), ops_count, completion_tag(flags).data);
 
   grpc_byte_buffer_destroy(buffer);  
 
   if (call_status != GRPC_CALL_OK) {
-    // There's not much we can do about this beyond logging it.
-    assert(false);  // TODO: HANDLE THIS
+    finish_after_failed_batch(call_status, completion_tag(flags));
   }
 }
 
 void send_failure(std::exception_ptr error, bool with_metadata, std::bitset<4> flags) {
+  send_failure(error, with_metadata, completion_tag(flags));
+}
+
+void send_failure(std::exception_ptr error, bool with_metadata, Completion_tag tag) {
   std::array<grpc_op, 3> ops;
 
-  std::size_t ops_count = 2;
+  std::size_t ops_count = 1;
   auto [status, details] = get_error_details(error);
 
   op_send_status(ops[0], status, &details);
-  op_recv_close(ops[1]);
+
+  if(!state_) {
+    op_recv_close(ops[ops_count++]);
+  }
 
   if(with_metadata) {
-    ++ops_count;
-    op_send_metadata(ops[2]);
+    op_send_metadata(ops[ops_count++]);
   }
 
   auto call_status =
-      grpc_call_start_batch(call_, ops.data(), ops_count, completion_tag(flags).data, nullptr);
+      start_batch(ops.data(), ops_count, tag.data);
 
   grpc_slice_unref(details);
 
   if (call_status != GRPC_CALL_OK) {
-    // There's not much we can do about this beyond logging it.
-    assert(false);  // TODO: HANDLE THIS
+    finish_after_failed_batch(call_status, tag);
+  }
+}
+
+// The batch that was meant to end the call could not be started, so tag
+// would never complete. Ends the call with INTERNAL instead, and completes
+// tag right away if even that can't be started.
+void finish_after_failed_batch(grpc_call_error error, Completion_tag tag) {
+  std::cerr << grpc_call_error_to_string(error) << "\n";
+
+  std::array<grpc_op, 2> ops;
+  std::size_t ops_count = 1;
+
+  grpc_slice details = grpc_slice_from_static_string("failed to send the reply");
+  op_send_status(ops[0], GRPC_STATUS_INTERNAL, &details);
+
+  if(!state_) {
+    op_recv_close(ops[ops_count++]);
+  }
+
+  auto call_status =
+      start_batch(ops.data(), ops_count, tag.data);
+  if (call_status == GRPC_CALL_OK) {
+    return;
+  }
+
+  grpc_call_cancel_with_status(call_, GRPC_STATUS_INTERNAL, "failed to send the reply", nullptr);
+
+  auto tag_int = reinterpret_cast<intptr_t>(tag.data);
+  auto callback = reinterpret_cast<Completion_callback*>(tag_int & ~intptr_t(0x0F));
+  if (callback->exec(false, std::bitset<4>(tag_int & 0x0F))) {
+    callback->release();
   }
 }
 
@@ -166,8 +371,37 @@ void send_failure(std::exception_ptr error, bool with_metadata, std::bitset<4> f
   //Reply-related
   int cancelled_ = false;
   grpc_metadata_array server_metadata_;
+  std::optional<grpc_compression_level> compression_level_;
+
+  // Only set while the close is being watched.
+  std::shared_ptr<Call_state> state_;
+  std::atomic<int> ends_left_ = 1;
+  Close_watcher close_watcher_{this};
+  Rejection rejection_{this};
+
+  // Set while the call holds a slot of its method's concurrency limit.
+  std::shared_ptr<Concurrency_limiter> limiter_;
+  std::chrono::steady_clock::time_point admitted_at_;
+
+  // Recycling
+  std::shared_ptr<Handler_pool_base> pool_;
+  Method_drain* drain_ = nullptr;
+  Call_handler* next_free_ = nullptr;
 };
 
+inline bool Close_watcher::exec(bool, std::bitset<4>) noexcept {
+  handler_->close_received();
+  return handler_->end_reached();
+}
+
+inline void Close_watcher::release() noexcept {
+  handler_->release();
+}
+
+inline void Rejection::release() noexcept {
+  handler_->release();
+}
+
 }  // namespace detail
 }  // namespace server
 }  // namespace easy_grpc
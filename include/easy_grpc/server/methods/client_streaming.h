@@ -22,6 +22,8 @@
 #include "easy_grpc/function_traits.h"
 #include "easy_grpc/server/methods/call_handler.h"
 
+#include "grpc/support/alloc.h"
+
 #include <cassert>
 #include <iostream>
 
@@ -33,6 +35,7 @@ template <typename ReqT, typename RepT, bool sync>
 class Client_streaming_call_handler : public Call_handler {
   Stream_promise<ReqT> reader_prom_;
   grpc_byte_buffer* payload_ = nullptr;
+  bool confirming_end_ = false;
   
 public:
   static constexpr bool immediate_payload = false;
@@ -40,16 +43,29 @@ public:
   Client_streaming_call_handler() = default;
   ~Client_streaming_call_handler() {}
 
+  void reset() {
+    // Fails the previous reader if the call ended before it was completed.
+    Stream_promise<ReqT> previous_reader(std::move(reader_prom_));
+    confirming_end_ = false;
+    Call_handler::reset();
+  }
+
   template<typename CbT>
-  void perform(const CbT& cb) {      
-    auto reply_fut = cb(reader_prom_.get_future());
+  void perform(const CbT& cb, const Method_options&) {      
+    if constexpr(takes_context_v<CbT>) {
+      watch_close();
+    }
+    auto reply_fut = invoke_handler(cb, state_, reader_prom_.get_future());
+
+    // The reply can go out before the upload is over.
+    expect_end();
 
     std::array<grpc_op, 2> ops;
     op_send_metadata(ops[0]);
     op_recv_message(ops[1], &payload_);
 
     auto call_status =
-        grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag().data, nullptr);
+        start_batch(ops.data(), ops.size(), completion_tag().data);
 
     if (call_status != GRPC_CALL_OK) {
       assert(false);  // TODO: HANDLE THIS
@@ -68,7 +84,19 @@ public:
     }
   }
 
-  bool exec(bool, std::bitset<4> flags) noexcept override {
+  // Ends the call on a request that can't be parsed, whatever the handler
+  // replies, and stops reading.
+  void reject_request(std::exception_ptr error) {
+    auto [status, details] = get_error_details(error);
+    auto str = grpc_slice_to_c_string(details);
+    grpc_call_cancel_with_status(call_, status, str, nullptr);
+    gpr_free(str);
+    grpc_slice_unref(details);
+
+    reader_prom_.set_exception(error);
+  }
+
+  bool exec(bool ok, std::bitset<4> flags) noexcept override {
     bool all_done = flags.test(0);
 
     if(!all_done) {
@@ -76,25 +104,55 @@ public:
         auto raw_data = payload_;
         payload_ = nullptr;
 
+        // The queue may have several threads: the next read must not be
+        // requested until this message is in the stream.
+        try {
+          reader_prom_.push(deserialize<ReqT>(raw_data));
+          grpc_byte_buffer_destroy(raw_data);
+        } catch(...) {
+          grpc_byte_buffer_destroy(raw_data);
+          reject_request(std::current_exception());
+          return end_reached();
+        }
+
         std::array<grpc_op, 1> ops;
         op_recv_message(ops[0], &payload_);
         
         auto call_status =
-            grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag().data, nullptr);
+            start_batch(ops.data(), ops.size(), completion_tag().data);
 
         if (call_status != GRPC_CALL_OK) {
           assert(false);
         }
+      }
+      else if(!ok || (state_ && state_->cancelled())) {
+        // The call died, rather than the client being done sending.
+        reader_prom_.set_exception(std::make_exception_ptr(error::cancelled("call cancelled")));
+        return end_reached();
+      }
+      else if(state_ && !confirming_end_) {
+        // Same as bidir calls: grpc reports a cancelled read just like the end
+        // of the requests, so read once more before believing it. Only calls
+        // whose close is watched can tell.
+        confirming_end_ = true;
+
+        std::array<grpc_op, 1> ops;
+        op_recv_message(ops[0], &payload_);
 
-        reader_prom_.push(deserialize<ReqT>(raw_data));
-        grpc_byte_buffer_destroy(raw_data);        
+        auto call_status =
+            start_batch(ops.data(), ops.size(), completion_tag().data);
+
+        if (call_status != GRPC_CALL_OK) {
+          assert(false);
+        }
       }
       else {
         reader_prom_.complete();
+        return end_reached();
       }
     }
 
-    return all_done;
+    return all_done && end_reached();
   }
 };
 }
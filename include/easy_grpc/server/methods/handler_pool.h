@@ -0,0 +1,135 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_METHOD_HANDLER_POOL_H_INCLUDED
+#define EASY_GRPC_SERVER_METHOD_HANDLER_POOL_H_INCLUDED
+
+#include "easy_grpc/server/method_stats.h"
+#include "easy_grpc/server/methods/call_handler.h"
+#include "easy_grpc/server/methods/method_drain.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace easy_grpc {
+namespace server {
+namespace detail {
+
+// Freelist of call handlers, shared by the listeners of a method on a given
+// completion queue. Handlers in flight hold a reference to their pool, so it
+// outlives the listeners if needed.
+//
+// At most max_free handlers are kept, so that a burst of calls does not leave
+// its peak number of handlers allocated for the rest of the server's life.
+template <typename HandlerT>
+class Handler_pool : public Handler_pool_base,
+                     public std::enable_shared_from_this<Handler_pool<HandlerT>> {
+ public:
+  Handler_pool(std::shared_ptr<Method_stats> stats,
+               std::shared_ptr<Method_drain> drain, std::size_t max_free)
+      : stats_(std::move(stats)), drain_(std::move(drain)), max_free_(max_free) {}
+
+  ~Handler_pool() {
+    while (free_) {
+      auto handler = free_;
+      free_ = handler->next_free_;
+      delete handler;
+    }
+  }
+
+  HandlerT* acquire() {
+    HandlerT* result = nullptr;
+    {
+      std::lock_guard l(mtx_);
+      if (free_) {
+        result = static_cast<HandlerT*>(free_);
+        free_ = result->next_free_;
+        result->next_free_ = nullptr;
+        --free_count_;
+      }
+    }
+
+    if (result) {
+      stats_->handlers_reused.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      result = new HandlerT;
+      stats_->handlers_allocated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    result->pool_ = this->shared_from_this();
+    result->drain_ = drain_.get();
+    return result;
+  }
+
+  // The handler was handed an actual call.
+  void call_started() {
+    stats_->calls_in_flight.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void call_expired() {
+    stats_->calls_expired.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void call_shed() {
+    stats_->calls_shed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void recycle(Call_handler* handler) override {
+    auto limiter = std::move(handler->limiter_);
+    auto latency = std::chrono::steady_clock::now() - handler->admitted_at_;
+
+    static_cast<HandlerT*>(handler)->reset();
+    // Sequentially consistent, so that either the server sees the count drop,
+    // or this sees it draining.
+    stats_->calls_in_flight.fetch_sub(1);
+    drain_->call_done();
+
+    bool kept = false;
+    {
+      std::lock_guard l(mtx_);
+      if (free_count_ < max_free_) {
+        handler->next_free_ = free_;
+        free_ = handler;
+        ++free_count_;
+        kept = true;
+      }
+    }
+    if (!kept) {
+      delete static_cast<HandlerT*>(handler);
+      stats_->handlers_freed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // This can start queued calls.
+    if (limiter) {
+      limiter->release(latency);
+    }
+  }
+
+ private:
+  std::shared_ptr<Method_stats> stats_;
+  std::shared_ptr<Method_drain> drain_;
+
+  std::size_t max_free_;
+
+  std::mutex mtx_;
+  Call_handler* free_ = nullptr;
+  std::size_t free_count_ = 0;
+};
+
+}  // namespace detail
+}  // namespace server
+}  // namespace easy_grpc
+#endif
@@ -16,8 +16,12 @@
 #define EASY_GRPC_SERVER_METHOD_LISTENER_H_INCLUDED
 
 #include "easy_grpc/completion_queue.h"
+#include "easy_grpc/error.h"
+#include "easy_grpc/server/method_options.h"
+#include "easy_grpc/server/methods/handler_pool.h"
 
 #include <iostream>
+#include <memory>
 namespace easy_grpc {
 namespace server {
 namespace detail {
@@ -27,8 +31,11 @@ class Method_listener : public Completion_callback {
     using handler_type = HandlerT;
  public:
   Method_listener(grpc_server* server, void* registration,
-                      grpc_completion_queue* cq, CbT cb)
-      : srv_(server), reg_(registration), cq_(cq), cb_(std::move(cb)) {
+                      grpc_completion_queue* cq, CbT cb,
+                      std::shared_ptr<Handler_pool<HandlerT>> pool,
+                      Method_options options)
+      : srv_(server), reg_(registration), cq_(cq), cb_(std::move(cb)),
+        pool_(std::move(pool)), options_(std::move(options)) {
     // It's really important that inject is not called here. As the object
     // could end up being deleted before it's fully constructed.
   }
@@ -43,23 +50,60 @@ class Method_listener : public Completion_callback {
     EASY_GRPC_TRACE(Method_listener, exec);
 
     if (success) {
-      pending_call_->perform(cb_);
+      auto call = pending_call_;
       pending_call_ = nullptr;
+      pool_->call_started();
 
-      // Listen for a new call.
+      // Listen for a new call before handling this one, so that the other
+      // threads of the queue can pick it up in the meantime.
       inject();
+
+      auto& limiter = options_.concurrency_limit;
+      if (!limiter || call->expired()) {
+        dispatch_(call, cb_, options_, *pool_);
+      } else if (limiter->try_acquire()) {
+        call->hold_slot(limiter);
+        dispatch_(call, cb_, options_, *pool_);
+      } else {
+        // The listener can be gone by the time the call gets a slot.
+        auto queued = limiter->enqueue(
+            [call, cb = cb_, options = options_, pool = pool_]() {
+              call->hold_slot(options.concurrency_limit);
+              dispatch_(call, cb, options, *pool);
+            });
+
+        if (!queued) {
+          pool_->call_shed();
+          call->reject(std::make_exception_ptr(
+              error::resource_exhausted("too many calls in flight")));
+        }
+      }
       return false;  // This object is recycled.
     }
 
     return true;
   }
 
+  // Calls that waited past their deadline are not worth spending any time on.
+  static void dispatch_(handler_type* call, const CbT& cb,
+                        const Method_options& options,
+                        Handler_pool<HandlerT>& pool) {
+    if (call->expired()) {
+      pool.call_expired();
+      call->reject(std::make_exception_ptr(
+          error::deadline_exceeded("deadline expired before dispatch")));
+    } else {
+      call->set_compression_level(options.compression_level);
+      call->perform(cb, options);
+    }
+  }
+
   void inject() {
     EASY_GRPC_TRACE(Method_listener, inject);
 
     assert(pending_call_ == nullptr);
 
-    pending_call_ = new handler_type;
+    pending_call_ = pool_->acquire();
 
     grpc_call_error status;
     if constexpr (handler_type::immediate_payload) {
@@ -87,6 +131,8 @@ class Method_listener : public Completion_callback {
   void* reg_;
   grpc_completion_queue* cq_;
   CbT cb_;
+  std::shared_ptr<Handler_pool<HandlerT>> pool_;
+  Method_options options_;
 
   handler_type* pending_call_ = nullptr;
 };
@@ -1,94 +1,151 @@
-// Copyright 2019 Age of Minds inc.
-
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-//
-//     http://www.apache.org/licenses/LICENSE-2.0
-
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#ifndef EASY_GRPC_SERVER_METHOD_H_INCLUDED
-#define EASY_GRPC_SERVER_METHOD_H_INCLUDED
-
-#include "easy_grpc/completion_queue.h"
-#include "easy_grpc/function_traits.h"
-
-#include "easy_grpc/server/methods/listener.h"
-
-namespace easy_grpc {
-namespace server {
-namespace detail {
-
-template<typename T>
-struct Arg_extractor {
-  using type = T;
-  static constexpr bool sync = true;
-};
-
-template<typename T>
-struct Arg_extractor<Future<T>> {
-  using type = T;
-  static constexpr bool sync = false;
-};
-
-template<typename T>
-struct Arg_extractor<Stream_future<T>> {
-  using type = T;
-  static constexpr bool sync = false;
-};
-
-class Method {
- public:
-  Method(const char* name) : name_(name) {}
-  virtual ~Method() {}
-
-  const char* name() const { return name_; }
-
-  void set_queues(Completion_queue_set queues) { queues_ = queues; }
-  const Completion_queue_set& queues() const { return queues_; }
-
-  virtual void listen(grpc_server* server, void* registration,
-                      grpc_completion_queue* cq) = 0;
-
-  virtual bool immediate_payload_read() const = 0;
- private:
-  Completion_queue_set queues_;
-  const char* name_;
-};
-
-
-template<template<typename, typename, bool> typename HandlerT, typename CbT>
-class Method_impl : public Method {
-  using CbArgT = typename function_traits<CbT>::template arg<0>::type;
-  using CbResultT = typename function_traits<CbT>::result_type;
-
-  using InT = typename Arg_extractor<CbArgT>::type;
-  using OutT = typename Arg_extractor<CbResultT>::type;
-
-  using handler_type = HandlerT<InT, OutT, Arg_extractor<CbResultT>::sync>;
-public:
- Method_impl(const char* name, CbT cb) : Method(name), cb_(cb) {}
-
-  void listen(grpc_server* server, void* registration,
-              grpc_completion_queue* cq) override {
-
-    auto listener = new Method_listener<CbT, handler_type>(server, registration, cq, cb_);
-    listener->inject();
-  }
-
-  bool immediate_payload_read() const override {
-    return handler_type::immediate_payload;
-  }
-
- private:
-  CbT cb_;
-};
-}  // namespace detail
-}  // namespace server
-}  // namespace easy_grpc
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_METHOD_H_INCLUDED
+#define EASY_GRPC_SERVER_METHOD_H_INCLUDED
+
+#include "easy_grpc/completion_queue.h"
+#include "easy_grpc/function_traits.h"
+#include "easy_grpc/stream_writer.h"
+
+#include "easy_grpc/server/method_options.h"
+#include "easy_grpc/server/method_stats.h"
+#include "easy_grpc/server/methods/handler_pool.h"
+#include "easy_grpc/server/methods/listener.h"
+#include "easy_grpc/server/methods/method_drain.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace easy_grpc {
+namespace server {
+namespace detail {
+
+template<typename T>
+struct Arg_extractor {
+  using type = T;
+  static constexpr bool sync = true;
+};
+
+template<typename T>
+struct Arg_extractor<Future<T>> {
+  using type = T;
+  static constexpr bool sync = false;
+};
+
+template<typename T>
+struct Arg_extractor<Stream_future<T>> {
+  using type = T;
+  static constexpr bool sync = false;
+};
+
+template<typename T>
+struct Arg_extractor<Stream_writer<T>> {
+  using type = T;
+  static constexpr bool sync = false;
+};
+
+// The type of a callback's second argument, if it has one. This is either a
+// Stream_writer or a Call_context.
+template<typename CbT, typename Enable = void>
+struct Writer_arg {
+  using type = void;
+};
+
+template<typename CbT>
+struct Writer_arg<CbT, std::enable_if_t<(function_traits<CbT>::arity >= 2)>> {
+  using type = std::decay_t<typename function_traits<CbT>::template arg<1>::type>;
+};
+
+template<typename CbT>
+constexpr bool takes_writer_v = is_stream_writer_v<typename Writer_arg<CbT>::type>;
+
+class Method {
+ public:
+  Method(const char* name)
+    : stats_(std::make_shared<Method_stats>()),
+      drain_(std::make_shared<Method_drain>(stats_)),
+      name_(name) {}
+  virtual ~Method() {}
+
+  const char* name() const { return name_; }
+
+  void set_queues(Completion_queue_set queues) { queues_ = queues; }
+  const Completion_queue_set& queues() const { return queues_; }
+
+  void set_options(Method_options options) { options_ = options; }
+  const Method_options& options() const { return options_; }
+
+  const std::shared_ptr<Method_stats>& stats() const { return stats_; }
+  const std::shared_ptr<Method_drain>& drain() const { return drain_; }
+
+  virtual void listen(grpc_server* server, void* registration,
+                      grpc_completion_queue* cq) = 0;
+
+  virtual bool immediate_payload_read() const = 0;
+ private:
+  Completion_queue_set queues_;
+  Method_options options_;
+  std::shared_ptr<Method_stats> stats_;
+  std::shared_ptr<Method_drain> drain_;
+  const char* name_;
+};
+
+
+// Handler type for callbacks that take the request as their argument, and
+// either return the reply or write it to a Stream_writer passed as second
+// argument. Either can be followed by a Call_context.
+template<template<typename, typename, bool> typename HandlerT, typename CbT>
+struct Handler_for {
+  using CbArgT = std::decay_t<typename function_traits<CbT>::template arg<0>::type>;
+  using CbResultT = typename function_traits<CbT>::result_type;
+  using WriterT = typename Writer_arg<CbT>::type;
+  using ReplyArgT = std::conditional_t<is_stream_writer_v<WriterT>, WriterT, CbResultT>;
+
+  using InT = typename Arg_extractor<CbArgT>::type;
+  using OutT = typename Arg_extractor<ReplyArgT>::type;
+
+  using type = HandlerT<InT, OutT, Arg_extractor<CbResultT>::sync>;
+};
+
+template<typename HandlerT, typename CbT>
+class Method_impl : public Method {
+  using handler_type = HandlerT;
+public:
+ Method_impl(const char* name, CbT cb) : Method(name), cb_(cb) {}
+
+  void listen(grpc_server* server, void* registration,
+              grpc_completion_queue* cq) override {
+
+    auto depth = std::max<std::size_t>(options().listener_depth, 1);
+    // Each listener takes a handler from the pool when it is re-armed.
+    auto pool = std::make_shared<Handler_pool<handler_type>>(stats(), drain(), depth);
+
+    for (std::size_t i = 0; i < depth; ++i) {
+      auto listener = new Method_listener<CbT, handler_type>(server, registration, cq, cb_, pool, options());
+      listener->inject();
+    }
+  }
+
+  bool immediate_payload_read() const override {
+    return handler_type::immediate_payload;
+  }
+
+ private:
+  CbT cb_;
+};
+}  // namespace detail
+}  // namespace server
+}  // namespace easy_grpc
 #endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_SERVER_METHOD_DRAIN_H_INCLUDED
+#define EASY_GRPC_SERVER_METHOD_DRAIN_H_INCLUDED
+
+#include "easy_grpc/server/method_stats.h"
+
+#include "grpc/grpc.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace easy_grpc {
+namespace server {
+namespace detail {
+
+// Lets the server wait for the calls of one of its methods to be over while
+// it shuts down, and cut off the handlers that are still running once it
+// gives up waiting.
+class Method_drain {
+ public:
+  explicit Method_drain(std::shared_ptr<const Method_stats> stats)
+      : stats_(std::move(stats)) {}
+
+  // A call's handler is done. Only signals once the server is waiting.
+  void call_done() {
+    if (draining_.load()) {
+      { std::lock_guard l(mtx_); }
+      cv_.notify_all();
+    }
+  }
+
+  // Waits until the method has no call in flight. Returns false if that's
+  // still not the case by deadline.
+  bool wait_until(std::chrono::steady_clock::time_point deadline) {
+    draining_.store(true);
+    std::unique_lock l(mtx_);
+    return cv_.wait_until(l, deadline, [this] {
+      return stats_->calls_in_flight.load() == 0;
+    });
+  }
+
+  // Starts a batch on one of the method's calls. Once the method is
+  // abandoned, the batch is dropped instead, and never completes.
+  grpc_call_error start_batch(grpc_call* call, const grpc_op* ops,
+                              std::size_t count, void* tag) {
+    auto result = GRPC_CALL_OK;
+    ++starting_;
+    if (!abandoned_) {
+      result = grpc_call_start_batch(call, ops, count, tag, nullptr);
+    }
+    --starting_;
+    return result;
+  }
+
+  // The server is going away while handlers of the method are still running.
+  // Waits for the batches being started, so that none of them reaches grpc
+  // after this returns.
+  void abandon() {
+    abandoned_ = true;
+    while (starting_ != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  std::shared_ptr<const Method_stats> stats_;
+
+  std::atomic<bool> draining_ = false;
+  std::atomic<bool> abandoned_ = false;
+  std::atomic<int> starting_ = 0;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+}  // namespace detail
+}  // namespace server
+}  // namespace easy_grpc
+#endif
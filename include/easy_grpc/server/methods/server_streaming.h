@@ -20,36 +20,51 @@
 
 #include "easy_grpc/function_traits.h"
 #include "easy_grpc/serialize.h"
+#include "easy_grpc/stream_writer.h"
 #include "easy_grpc/server/methods/call_handler.h"
 
 #include <cassert>
-#include <queue>
 #include <iostream>
+#include <memory>
+#include <tuple>
 
 namespace easy_grpc {
 namespace server {
 namespace detail {
 
 template <typename ReqT, typename RepT, bool sync>
-class Server_streaming_call_handler : public Call_handler {
+class Server_streaming_call_handler : public Call_handler, public easy_grpc::detail::Message_sink {
+  static constexpr int close_tag = 1;
+  static constexpr int metadata_tag = 2;
+
 public:
 
   grpc_byte_buffer* payload_ = nullptr;
   static constexpr bool immediate_payload = true;
-  
+
+  ~Server_streaming_call_handler() {
+    if(writer_) {
+      writer_->detach();
+    }
+  }
+
   template<typename CbT>
-  void perform(const CbT& handler) {
+  void perform(const CbT& handler, const Method_options& options) {
     assert(this->payload_);
-    
-    auto req = deserialize<ReqT>(this->payload_);
-    grpc_byte_buffer_destroy(this->payload_);
 
-    batch_in_flight_ = true;
+    // Handlers that return a Stream_future can't be slowed down, so their
+    // replies are queued without bound.
+    constexpr bool writer_mode = takes_writer_v<CbT>;
+    writer_ = std::make_shared<easy_grpc::detail::Writer_state<RepT>>(
+        writer_mode ? options.stream_capacity : 0, options.coalesce_writes);
+
+    // Stops the stream as soon as the client goes away.
+    watch_close();
 
     std::array<grpc_op, 1> ops;
     op_send_metadata(ops[0]);
     auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag().data, nullptr);
+      start_batch(ops.data(), ops.size(), completion_tag(metadata_tag).data);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
@@ -57,119 +72,110 @@ public:
     assert(status == GRPC_CALL_OK);
 
     try {
-      handler(req).for_each([this](RepT rep) {
-        push(rep);
-      }).finally([this](expected<void> status) {
-        if(status.has_value()) {
-          finish();
-        }
-        else {
-          fail(status.error());
-        }
-      });
+      auto req = take_request();
+      if constexpr(writer_mode) {
+        // An lvalue, so that handlers can take the writer by reference.
+        Stream_writer<RepT> writer(writer_);
+        invoke_handler(handler, state_, std::move(req), writer);
+      }
+      else {
+        invoke_handler(handler, state_, std::move(req)).for_each([w = writer_](RepT rep) {
+          w->push(std::move(rep));
+        }).finally([w = writer_](expected<void> status) {
+          if(status.has_value()) {
+            w->complete();
+          }
+          else {
+            w->fail(status.error());
+          }
+        });
+      }
     } catch(...) {
-      fail(std::current_exception());
+      writer_->fail(std::current_exception());
     }
   }
 
-  void push(const RepT& val) {
-    std::lock_guard l(mtx_);
-    
-    grpc_op op;
-    op_send_message(op, serialize(val));
-
-    pending_ops_.push(op);
-
-    flush_();
+  // Deserializes the request, and frees its payload whether that works or not.
+  ReqT take_request() {
+    auto payload = this->payload_;
+    this->payload_ = nullptr;
+    try {
+      auto req = deserialize<ReqT>(payload);
+      grpc_byte_buffer_destroy(payload);
+      return req;
+    } catch(...) {
+      grpc_byte_buffer_destroy(payload);
+      throw;
+    }
   }
 
-  void finish() {
-    std::lock_guard l(mtx_);
-
-    finished_ = true;
-
-    if(!batch_in_flight_) {
-      send_end();
+  void reset() {
+    if(writer_) {
+      writer_->detach();
+      writer_.reset();
     }
+    Call_handler::reset();
   }
 
-  void fail(std::exception_ptr) {
-    
-    std::lock_guard l(mtx_);
-
-    std::array<grpc_op, 2> ops;
-
-    op_send_status(ops[0]);
-    op_recv_close(ops[1]);
-
-    auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(true).data, nullptr);
-
-    if(status != GRPC_CALL_OK) {
-      std::cerr << grpc_call_error_to_string(status) << "\n";
-      assert(false);
-    }
+  void on_cancelled() override {
+    writer_->cancel();
   }
 
-  bool exec(bool, std::bitset<4> flags) noexcept override {
+  bool exec(bool ok, std::bitset<4> flags) noexcept override {
     if(flags.test(0)) {
-      return true;
+      return end_reached();
     }
 
-    std::lock_guard l(mtx_);
-    batch_in_flight_ = false;
-
-    if(!pending_ops_.empty()) {
-      flush_();
-    } else if(finished_) {
-      send_end();
+    if(flags.test(1)) {
+      writer_->attach(this, ok);
+    }
+    else {
+      writer_->on_written(ok);
     }
     return false;
   }
 
-  void send_end() {
-    std::array<grpc_op, 2> ops;
-
-    op_recv_close(ops[0]);
-    op_send_status(ops[1]);
+  void write(grpc_byte_buffer* buffer, bool buffered) override {
+    grpc_op op;
+    op_send_message(op, buffer);
+    if(buffered) {
+      op.flags = GRPC_WRITE_BUFFER_HINT;
+    }
 
     auto status =
-      grpc_call_start_batch(call_, ops.data(), ops.size(), completion_tag(1).data, nullptr);
+      start_batch(&op, 1, completion_tag().data);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
-      assert(false);
     }
+    assert(status == GRPC_CALL_OK);
+    
+    grpc_byte_buffer_destroy(buffer);
   }
 
-  void flush_() {
-    if(batch_in_flight_) {
-      return ;
+  void close(std::exception_ptr error) override {
+    grpc_status_code code = GRPC_STATUS_OK;
+    grpc_slice details = grpc_empty_slice();
+    if(error) {
+      std::tie(code, details) = get_error_details(error);
     }
 
-    batch_in_flight_ = true;
-
-    auto op = pending_ops_.front();
-    pending_ops_.pop();
+    // The close itself is received through watch_close().
+    std::array<grpc_op, 1> ops;
+    op_send_status(ops[0], code, &details);
 
-    assert(op.op == GRPC_OP_SEND_MESSAGE);
-    
     auto status =
-      grpc_call_start_batch(call_, &op, 1, completion_tag().data, nullptr);
+      start_batch(ops.data(), ops.size(), completion_tag(close_tag).data);
+    grpc_slice_unref(details);
 
     if(status != GRPC_CALL_OK) {
       std::cerr << grpc_call_error_to_string(status) << "\n";
+      assert(false);
     }
-    assert(status == GRPC_CALL_OK);
-    
-    grpc_byte_buffer_destroy(op.data.send_message.send_message);
   }
 
-  // I really wish we could do this without a mutex, somehow...
-  std::mutex mtx_;
-  bool finished_ = false;
-  bool batch_in_flight_ = false;
-  std::queue<grpc_op> pending_ops_;
+private:
+  std::shared_ptr<easy_grpc::detail::Writer_state<RepT>> writer_;
 };
 }
 }
@@ -19,12 +19,14 @@
 #include "easy_grpc/error.h"
 #include "easy_grpc/serialize.h"
 #include "easy_grpc/function_traits.h"
+#include "easy_grpc/server/method_options.h"
 #include "easy_grpc/server/methods/call_handler.h"
 #include "var_future/future.h"
 
 #include "grpc/grpc.h"
 
 #include <cassert>
+#include <utility>
 
 namespace easy_grpc {
 namespace server {
@@ -46,17 +48,50 @@ public:
     }
   }
 
+  void reset() {
+    if(payload_) {
+      grpc_byte_buffer_destroy(payload_);
+      payload_ = nullptr;
+    }
+    Call_handler::reset();
+  }
+
   bool exec(bool, std::bitset<4>) noexcept override {
-    return true;
+    return this->end_reached();
   }
 
   void finish(expected<RepT> rep) {
     if (rep.has_value()) {
-      send_unary_response(rep.value(), true, false);
+      send_unary_response(std::move(rep.value()), true, false);
     } else {
       send_failure(rep.error(), true, false);
     }
   }
+
+  // A call cancelled before its request came in, e.g. the losing copy of a
+  // hedged call, reaches the handler without a payload. It only needs to be
+  // closed then.
+  bool cancelled_early() {
+    if (payload_) {
+      return false;
+    }
+    this->reject(std::make_exception_ptr(
+        error::cancelled("call cancelled before its request came in")));
+    return true;
+  }
+
+  // Runs f on the method's worker pool if it has one, inline otherwise.
+  template <typename F>
+  void run_sync(const Method_options& options, F f) {
+    if (options.worker_pool) {
+      if (!options.worker_pool->try_push(std::move(f))) {
+        send_failure(std::make_exception_ptr(
+            error::resource_exhausted("worker pool is saturated")), true, false);
+      }
+    } else {
+      f();
+    }
+  }
 };
 
 template <typename ReqT, typename RepT, bool sync>
@@ -67,12 +102,25 @@ template <typename ReqT, typename RepT>
 class Unary_call_handler<ReqT, RepT, true> : public Unary_call_handler_base<RepT> {
  public:
   template <typename HandlerT>
-  void perform(const HandlerT& handler) {
+  void perform(const HandlerT& handler, const Method_options& options) {
+    if (this->cancelled_early()) {
+      return;
+    }
+    if constexpr (takes_context_v<HandlerT>) {
+      this->watch_close();
+    }
+    // The task owns a copy of the handler, as the listener can go away
+    // while it is queued.
+    this->run_sync(options, [this, handler]() { this->perform_now(handler); });
+  }
+
+  template <typename HandlerT>
+  void perform_now(const HandlerT& handler) {
     assert(this->payload_);
-    auto req = deserialize<ReqT>(this->payload_);
     expected<RepT> result;
     try {
-      result = handler(req);
+      auto req = deserialize<ReqT>(this->payload_);
+      result = invoke_handler(handler, this->state_, req);
     } catch (...) {
       result = unexpected{std::current_exception()};
     }
@@ -89,18 +137,84 @@ class Unary_call_handler<ReqT, RepT, false>
   using value_type = RepT;
 
   template <typename HandlerT>
-  void perform(const HandlerT& handler) {
-    assert(this->payload_);
-    auto req = deserialize<ReqT>(this->payload_);
+  void perform(const HandlerT& handler, const Method_options&) {
+    if (this->cancelled_early()) {
+      return;
+    }
+    if constexpr (takes_context_v<HandlerT>) {
+      this->watch_close();
+    }
     
     try {
-      handler(req).finally(
+      auto req = deserialize<ReqT>(this->payload_);
+      invoke_handler(handler, this->state_, req).finally(
         [this](expected<value_type> rep) { this->finish(rep); });
     } catch (...) {
       this->finish(unexpected{std::current_exception()});
     }
   }
 };
+
+// Handlers taking (const ReqT&, RepT&). Both messages are allocated on an
+// arena owned by the handler, which is cleared when the handler is recycled.
+template <typename ReqT, typename RepT, bool sync>
+class Arena_unary_call_handler : public Unary_call_handler_base<RepT> {
+  using arena_type = typename Serializer<ReqT>::arena_type;
+  static_assert(std::is_same_v<arena_type, typename Serializer<RepT>::arena_type>);
+
+ public:
+  void reset() {
+    req_ = nullptr;
+    rep_ = nullptr;
+    arena_.reset();
+    Unary_call_handler_base<RepT>::reset();
+  }
+
+  template <typename HandlerT>
+  void perform(const HandlerT& handler, const Method_options& options) {
+    if constexpr (takes_context_v<HandlerT>) {
+      this->watch_close();
+    }
+    if constexpr (sync) {
+      this->run_sync(options, [this, handler]() { this->perform_now(handler); });
+    } else {
+      perform_now(handler);
+    }
+  }
+
+  template <typename HandlerT>
+  void perform_now(const HandlerT& handler) {
+    assert(this->payload_);
+
+    try {
+      req_ = Serializer<ReqT>::deserialize(this->payload_, arena_);
+      rep_ = Serializer<RepT>::create(arena_);
+
+      if constexpr (sync) {
+        invoke_handler(handler, this->state_, std::as_const(*req_), *rep_);
+        finish(expected<void>());
+      } else {
+        invoke_handler(handler, this->state_, std::as_const(*req_), *rep_).finally(
+            [this](expected<void> status) { this->finish(status); });
+      }
+    } catch (...) {
+      finish(unexpected{std::current_exception()});
+    }
+  }
+
+  void finish(expected<void> status) {
+    if (status.has_value()) {
+      this->send_unary_response(*rep_, true, false);
+    } else {
+      this->send_failure(status.error(), true, false);
+    }
+  }
+
+ private:
+  arena_type arena_;
+  ReqT* req_ = nullptr;
+  RepT* rep_ = nullptr;
+};
 }  // namespace detail
 }  // namespace server
 }  // namespace easy_grpc
@@ -15,12 +15,18 @@
 #ifndef EASY_GRPC_SERVER_SERVER_H_INCLUDED
 #define EASY_GRPC_SERVER_SERVER_H_INCLUDED
 
+#include "easy_grpc/channel_args.h"
 #include "easy_grpc/completion_queue.h"
+#include "easy_grpc/compression.h"
 #include "easy_grpc/server/credentials.h"
+#include "easy_grpc/server/method_stats.h"
+#include "easy_grpc/server/methods/method_drain.h"
 #include "easy_grpc/server/service_config.h"
 
 #include "grpc/grpc.h"
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -88,6 +94,19 @@ class Config {
                             std::shared_ptr<Credentials> creds = {},
                             int* bound_port = nullptr) &&;
 
+  // Compression of the replies of methods that do not set their own.
+  Config& set_default_compression(Compression_options options) &;
+  Config&& set_default_compression(Compression_options options) &&;
+
+  // Transport settings, merged with the ones added before.
+  Config& add_channel_args(const Channel_args& args) &;
+  Config&& add_channel_args(const Channel_args& args) &&;
+
+  // How long destroying the server waits for the handlers of cancelled calls
+  // to finish. Defaults to 5 seconds.
+  Config& set_shutdown_grace_period(std::chrono::milliseconds period) &;
+  Config&& set_shutdown_grace_period(std::chrono::milliseconds period) &&;
+
   const std::vector<Service_config>& get_services() const;
 
  private:
@@ -101,6 +120,8 @@ class Config {
   std::vector<Service_config> service_cfgs_;
   std::vector<Port> ports_;
   std::vector<std::unique_ptr<Feature>> features_;
+  Channel_args args_;
+  std::chrono::milliseconds shutdown_grace_period_ = std::chrono::seconds(5);
   friend class Server;
 };
 
@@ -110,10 +131,19 @@ class Server {
   Server(Config cfg);
   Server(Server&& rhs);
   Server& operator=(Server&& rhs);
+
+  // Cancels the calls in progress, and waits for their handlers to finish, up
+  // to the config's shutdown grace period. Handlers still running after that
+  // are abandoned: whatever they send later is dropped, and they are never
+  // released.
   ~Server();
 
   grpc_server* handle() { return impl_; }
 
+  // Counters of the method with the given full name ("/package.Service/Method"),
+  // or nullptr if the server does not have it.
+  std::shared_ptr<const Method_stats> method_stats(const std::string& name) const;
+
  private:
   void add_listening_ports_(const Config& cfg);
   void cleanup_();
@@ -126,8 +156,11 @@ class Server {
   Completion_queue_set default_queues_;
 
   grpc_completion_queue* shutdown_queue_ = nullptr;
+  std::chrono::milliseconds shutdown_grace_period_ = std::chrono::seconds(5);
 
   std::vector<std::unique_ptr<Feature>> features_;
+  std::map<std::string, std::shared_ptr<const Method_stats>> method_stats_;
+  std::vector<std::shared_ptr<detail::Method_drain>> method_drains_;
 };
 }  // namespace server
 
@@ -19,6 +19,8 @@
 #include "easy_grpc/function_traits.h"
 #include "var_future/future.h"
 
+#include <cstring>
+#include <stdexcept>
 #include <string>
 
 namespace easy_grpc {
@@ -30,15 +32,21 @@ class Service_config {
   Service_config(std::string name) : name_(std::move(name)) {}
 
   template <typename CbT>
-  void add_method(const char* name, CbT cb, Completion_queue_set={}) {
+  void add_method(const char* name, CbT cb, Completion_queue_set queues = {},
+                  Method_options options = {}) {
     using cb_traits = function_traits<CbT>;
     
     constexpr bool c_streaming = is_server_reader_v<typename cb_traits::template arg<0>::type>;
-    // This is the check we WANT, but it's not that simple...
-    // constexpr bool s_streaming = cb_traits::arity > 1 && is_server_writer_v<typename cb_traits::template arg<1>::type>;
-    constexpr bool s_streaming = is_server_writer_v<std::decay_t<typename cb_traits::result_type>>;
+    // Replies are streamed either by returning a Stream_future, or through a
+    // Stream_writer passed as second argument.
+    constexpr bool s_streaming =
+        is_server_writer_v<std::decay_t<typename cb_traits::result_type>> ||
+        is_stream_writer_v<typename detail::Writer_arg<CbT>::type>;
 
-    if constexpr(c_streaming && s_streaming) {
+    if constexpr(is_arena_unary_handler_v<CbT>) {
+      methods_.emplace_back(detail::make_arena_unary_method(name, std::move(cb)));
+    }
+    else if constexpr(c_streaming && s_streaming) {
       methods_.emplace_back(detail::make_bidir_streaming_method(name, std::move(cb)));
     }
     else if constexpr(c_streaming) {
@@ -50,6 +58,28 @@ class Service_config {
     else {
       methods_.emplace_back(detail::make_unary_method(name, std::move(cb)));
     }
+
+    methods_.back()->set_queues(std::move(queues));
+    methods_.back()->set_options(std::move(options));
+  }
+
+  // Replaces the options of every method added so far.
+  void set_method_options(const Method_options& options) {
+    for (auto& method : methods_) {
+      method->set_options(options);
+    }
+  }
+
+  // Replaces the options of a single method, identified by its full name.
+  void set_method_options(const char* method_name,
+                          const Method_options& options) {
+    for (auto& method : methods_) {
+      if (std::strcmp(method->name(), method_name) == 0) {
+        method->set_options(options);
+        return;
+      }
+    }
+    throw std::invalid_argument(std::string("unknown method: ") + method_name);
   }
 
   const std::vector<std::unique_ptr<detail::Method>>& methods() const {
@@ -19,6 +19,7 @@
 #include "easy_grpc/server/methods/server_streaming.h"
 #include "easy_grpc/server/methods/client_streaming.h"
 #include "easy_grpc/server/methods/unary.h"
+#include "easy_grpc/stream_writer.h"
 
 #include <iostream>
 
@@ -29,22 +30,37 @@ namespace detail {
 
 template <typename CbT>
 auto make_unary_method(const char* name, CbT cb) {
-  return std::make_unique<Method_impl<Unary_call_handler, CbT>>(name, std::move(cb));
+  using handler_type = typename Handler_for<Unary_call_handler, CbT>::type;
+  return std::make_unique<Method_impl<handler_type, CbT>>(name, std::move(cb));
+}
+
+template <typename CbT>
+auto make_arena_unary_method(const char* name, CbT cb) {
+  using traits = function_traits<CbT>;
+  using ReqT = std::decay_t<typename traits::template arg<0>::type>;
+  using RepT = std::decay_t<typename traits::template arg<1>::type>;
+  constexpr bool sync = Arg_extractor<typename traits::result_type>::sync;
+
+  using handler_type = Arena_unary_call_handler<ReqT, RepT, sync>;
+  return std::make_unique<Method_impl<handler_type, CbT>>(name, std::move(cb));
 }
 
 template <typename CbT>
 auto make_server_streaming_method(const char* name, CbT cb) {
-  return std::make_unique<Method_impl<Server_streaming_call_handler, CbT>>(name, std::move(cb));
+  using handler_type = typename Handler_for<Server_streaming_call_handler, CbT>::type;
+  return std::make_unique<Method_impl<handler_type, CbT>>(name, std::move(cb));
 }
 
 template <typename CbT>
 auto make_client_streaming_method(const char* name, CbT cb) {
-  return std::make_unique<Method_impl<Client_streaming_call_handler, CbT>>(name, std::move(cb));
+  using handler_type = typename Handler_for<Client_streaming_call_handler, CbT>::type;
+  return std::make_unique<Method_impl<handler_type, CbT>>(name, std::move(cb));
 }
 
 template <typename CbT>
 auto make_bidir_streaming_method(const char* name, CbT cb) {
-  return std::make_unique<Method_impl<Bidir_streaming_call_handler, CbT>>(name, std::move(cb));
+  using handler_type = typename Handler_for<Bidir_streaming_call_handler, CbT>::type;
+  return std::make_unique<Method_impl<handler_type, CbT>>(name, std::move(cb));
 }
 
 
@@ -72,5 +88,25 @@ struct is_server_writer<Stream_future<T>> : public std::true_type {};
 
 template<typename T>
 constexpr bool is_server_writer_v = is_server_writer<T>::value;
+
+// Unary handlers shaped like (const ReqT&, RepT&) fill in a reply that is
+// owned, along with the request, by the call's arena. They can take a
+// Call_context as third argument. A Stream_writer taken by reference makes
+// a streaming handler instead.
+template<typename CbT, typename Enable = void>
+struct is_arena_unary_handler : public std::false_type {};
+
+template<typename CbT>
+struct is_arena_unary_handler<CbT, std::enable_if_t<(function_traits<CbT>::arity >= 2)>> {
+  using rep_arg = typename function_traits<CbT>::template arg<1>::type;
+
+  static constexpr bool value = std::is_lvalue_reference_v<rep_arg> &&
+                                !std::is_const_v<std::remove_reference_t<rep_arg>> &&
+                                !std::is_same_v<std::decay_t<rep_arg>, server::Call_context> &&
+                                !is_stream_writer_v<std::decay_t<rep_arg>>;
+};
+
+template<typename CbT>
+constexpr bool is_arena_unary_handler_v = is_arena_unary_handler<CbT>::value;
 }  // namespace easy_grpc
 #endif
\ No newline at end of file
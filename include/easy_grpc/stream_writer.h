@@ -0,0 +1,323 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_STREAM_WRITER_INCLUDED_H
+#define EASY_GRPC_STREAM_WRITER_INCLUDED_H
+
+#include "easy_grpc/config.h"
+#include "easy_grpc/error.h"
+#include "easy_grpc/mpsc_queue.h"
+#include "easy_grpc/serialize.h"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace easy_grpc {
+
+namespace detail {
+
+// The call a Writer_state sends its messages to.
+class Message_sink {
+ public:
+  virtual ~Message_sink() {}
+
+  // Sends a message. The sink owns the buffer, and must report back through
+  // Writer_state::on_written() once the message is out. If buffered is set,
+  // more messages follow right away, and the write does not need to be
+  // flushed to the network on its own (GRPC_WRITE_BUFFER_HINT).
+  virtual void write(grpc_byte_buffer* buffer, bool buffered) = 0;
+
+  // Ends the stream. error is null on success. Called exactly once.
+  virtual void close(std::exception_ptr error) = 0;
+};
+
+// Messages waiting to be sent on a stream, shared between the producers and
+// the call. Messages are only serialized once the call is ready to send them,
+// and at most one message is being written at any given time.
+//
+// Pushing never takes a lock: whoever holds the write token pops the next
+// message and hands it to the sink, and the token stays with the write until
+// it completes. Only producers that have to wait on ready() touch a mutex.
+template <typename T>
+class Writer_state {
+ public:
+  // A capacity of 0 means unbounded. With coalesce set, messages that have
+  // others queued behind them are written as buffered.
+  explicit Writer_state(std::size_t capacity, bool coalesce = false)
+      : capacity_(capacity), coalesce_(coalesce) {}
+
+  std::size_t capacity() const { return capacity_; }
+
+  bool push(T val) {
+    if (close_state_ != open || broken_) {
+      return false;
+    }
+
+    pending_.push(std::move(val));
+    ++size_;
+    try_write_();
+    return true;
+  }
+
+  Future<void> ready() {
+    Promise<void> prom;
+    auto result = prom.get_future();
+
+    if (broken_) {
+      prom.set_exception(broken_error());
+    } else if (has_room_()) {
+      prom.set_value();
+    } else {
+      {
+        std::lock_guard l(waiters_mtx_);
+        waiters_.push_back(std::move(prom));
+        has_waiters_ = true;
+      }
+      // Room may have been made before the waiter was visible.
+      notify_();
+    }
+    return result;
+  }
+
+  void complete() { close_(nullptr); }
+
+  void fail(std::exception_ptr error) { close_(std::move(error)); }
+
+  // Every Stream_writer is gone. A stream nobody ended is failed, so that
+  // the call does not stay open forever.
+  void abandon() {
+    if (close_state_ == open) {
+      close_(std::make_exception_ptr(
+          error::internal("stream writer released before the end of the stream")));
+    }
+  }
+
+  // The sink is ready to start writing. If ok is false, the call is already
+  // dead, and the sink is only ever closed.
+  void attach(Message_sink* sink, bool ok = true) {
+    if (!ok) {
+      broken_ = true;
+    }
+    sink_ = sink;
+    try_write_();
+    notify_();
+  }
+
+  // The previous write is done. A failed write means the stream is broken,
+  // typically because the call was cancelled.
+  void on_written(bool ok) {
+    if (!ok) {
+      broken_ = true;
+    }
+
+    writing_ = false;
+    try_write_();
+    notify_();
+  }
+
+  // The call was cancelled. Pending messages are dropped, and the sink is
+  // closed once no write is in flight anymore.
+  void cancel() {
+    broken_ = true;
+    try_write_();
+    notify_();
+  }
+
+  // The call is over, nothing can be sent anymore. Waits for any thread that
+  // is in the middle of handing a message to the sink.
+  void detach() {
+    sink_ = nullptr;
+    broken_ = true;
+    while (sink_users_ != 0) {
+      std::this_thread::yield();
+    }
+    notify_();
+  }
+
+ private:
+  enum Close_state { open, closing, closed };
+
+  static std::exception_ptr broken_error() {
+    return std::make_exception_ptr(error::cancelled("stream is closed"));
+  }
+
+  bool has_room_() const {
+    return capacity_ == 0 || size_ < static_cast<std::ptrdiff_t>(capacity_);
+  }
+
+  void close_(std::exception_ptr error) {
+    int expected = open;
+    if (!close_state_.compare_exchange_strong(expected, closing)) {
+      return;
+    }
+
+    error_ = std::move(error);
+    close_state_ = closed;
+    try_write_();
+  }
+
+  void try_write_() {
+    while (!writing_.exchange(true)) {
+      ++sink_users_;
+      bool started = start_write_();
+      --sink_users_;
+
+      // The token now belongs to the write, or close, in flight.
+      if (started) {
+        return;
+      }
+
+      writing_ = false;
+
+      // Something may have been pushed while the token was held.
+      if (!sink_ || (size_ <= 0 && close_state_ != closed && !broken_)) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Called with the write token held. Returns true if the sink was handed a
+  // message or closed.
+  bool start_write_() {
+    auto sink = sink_.load();
+    if (!sink) {
+      return false;
+    }
+
+    if (broken_ || (close_state_ == closed && error_)) {
+      drop_pending_();
+      sink->close(broken_ ? broken_error() : error_);
+      return true;
+    }
+
+    if (auto val = pending_.pop()) {
+      --size_;
+      sink->write(serialize(std::move(*val)), coalesce_ && !pending_.empty());
+      return true;
+    }
+
+    if (close_state_ == closed) {
+      sink->close(nullptr);
+      return true;
+    }
+    return false;
+  }
+
+  void drop_pending_() {
+    while (pending_.pop()) {
+      --size_;
+    }
+  }
+
+  void notify_() {
+    if (!has_waiters_) {
+      return;
+    }
+
+    std::vector<Promise<void>> waiters;
+    bool broken = broken_;
+    {
+      std::lock_guard l(waiters_mtx_);
+      if (!broken && !has_room_()) {
+        return;
+      }
+      waiters = std::move(waiters_);
+      waiters_.clear();
+      has_waiters_ = false;
+    }
+
+    for (auto& w : waiters) {
+      if (broken) {
+        w.set_exception(broken_error());
+      } else {
+        w.set_value();
+      }
+    }
+  }
+
+  std::size_t capacity_;
+  bool coalesce_;
+
+  Mpsc_queue<T> pending_;
+  // Can dip below zero while a pop races with the matching push.
+  std::atomic<std::ptrdiff_t> size_ = 0;
+
+  std::atomic<Message_sink*> sink_ = nullptr;
+  std::atomic<int> sink_users_ = 0;
+  std::atomic<bool> writing_ = false;
+  std::atomic<bool> broken_ = false;
+  std::atomic<int> close_state_ = open;
+  std::exception_ptr error_;
+
+  std::mutex waiters_mtx_;
+  std::atomic<bool> has_waiters_ = false;
+  std::vector<Promise<void>> waiters_;
+};
+}  // namespace detail
+
+// Bounded writing end of a stream.
+//
+// push() never blocks, so producers are expected to wait on ready() before
+// pushing more, which keeps at most capacity() messages waiting on the
+// network. Copies refer to the same stream. Once the last copy is gone, a
+// stream that was neither completed nor failed ends with GRPC_STATUS_INTERNAL.
+template <typename T>
+class Stream_writer {
+ public:
+  using value_type = T;
+
+  explicit Stream_writer(std::shared_ptr<detail::Writer_state<T>> state)
+      : state_(state.get(), [owner = state](detail::Writer_state<T>* s) {
+          s->abandon();
+        }) {}
+
+  // Queues a message. Returns false if the stream was closed or cancelled.
+  bool push(T val) { return state_->push(std::move(val)); }
+
+  // Resolves once fewer than capacity() messages are waiting to be sent.
+  // Fails if the stream gets cancelled in the meantime.
+  Future<void> ready() { return state_->ready(); }
+
+  // Ends the stream once the pending messages are sent.
+  void complete() { state_->complete(); }
+
+  // Ends the stream with an error, pending messages are dropped.
+  void set_exception(std::exception_ptr error) {
+    state_->fail(std::move(error));
+  }
+
+  std::size_t capacity() const { return state_->capacity(); }
+
+ private:
+  std::shared_ptr<detail::Writer_state<T>> state_;
+};
+
+template <typename T>
+struct is_stream_writer : public std::false_type {};
+
+template <typename T>
+struct is_stream_writer<Stream_writer<T>> : public std::true_type {};
+
+template <typename T>
+constexpr bool is_stream_writer_v = is_stream_writer<T>::value;
+}  // namespace easy_grpc
+
+#endif
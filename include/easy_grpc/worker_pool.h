@@ -0,0 +1,73 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EASY_GRPC_WORKER_POOL_INCLUDED_H
+#define EASY_GRPC_WORKER_POOL_INCLUDED_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace easy_grpc {
+
+// A set of threads running tasks from a bounded queue.
+//
+// This satisfies var_future's queue concept, so it can be passed to
+// Future::then() and friends, as well as used to take slow handlers off the
+// completion queues (see server::Method_options).
+class Worker_pool {
+ public:
+  explicit Worker_pool(std::size_t thread_count, std::size_t capacity = 1024);
+
+  // Runs the tasks that are still queued, and joins the threads.
+  ~Worker_pool();
+
+  // Runs task on the calling thread if the queue is full. This never blocks,
+  // as it is invoked from completion queue threads when the pool is used as a
+  // future queue, and from the pool's own tasks.
+  //
+  // Throws std::logic_error once the workers are gone.
+  void push(std::function<void()> task);
+
+  // Returns false instead if the queue is full.
+  bool try_push(std::function<void()> task);
+
+  std::size_t thread_count() const { return threads_.size(); }
+  std::size_t capacity() const { return capacity_; }
+
+ private:
+  void worker_main();
+
+  // Leaves task alone if the queue is full.
+  bool enqueue_(std::function<void()>& task);
+
+  // Noncopyable
+  Worker_pool(const Worker_pool&) = delete;
+  Worker_pool& operator=(const Worker_pool&) = delete;
+
+  std::mutex mtx_;
+  std::condition_variable not_empty_;
+  std::deque<std::function<void()>> tasks_;
+  std::size_t capacity_;
+  bool stopping_ = false;
+  std::size_t running_workers_ = 0;
+
+  std::vector<std::thread> threads_;
+};
+}  // namespace easy_grpc
+#endif
@@ -6,6 +6,7 @@
 
 #include <filesystem>
 #include <functional>
+#include <stdexcept>
 
 using google::protobuf::Descriptor;
 using google::protobuf::FileDescriptor;
@@ -80,6 +81,18 @@ std::string class_name(const Descriptor* desc) {
   return result.str();
 }
 
+// What a server-side handler receives for the method's requests.
+std::string request_type(const MethodDescriptor* method) {
+  if (method->client_streaming()) {
+    return "::easy_grpc::Stream_future<" + class_name(method->input_type()) + ">";
+  }
+  return class_name(method->input_type());
+}
+
+std::string writer_type(const MethodDescriptor* method) {
+  return "::easy_grpc::Stream_writer<" + class_name(method->output_type()) + ">";
+}
+
 std::string header_guard(std::string_view file_name) {
   std::ostringstream result;
   for (auto c : file_name) {
@@ -116,7 +129,27 @@ std::vector<std::string> package_parts(const FileDescriptor* file) {
   return tokenize(file->package(), '.');
 }
 
+// Set through the plugin parameter, e.g: --sgrpc_out=arena:<dir>
+struct Generator_options {
+  // Unary handlers take (const Req&, Rep&), with both messages living on a
+  // per-call arena.
+  bool arena = false;
+};
+
+Generator_options parse_options(const std::string& parameter) {
+  Generator_options result;
+  for (const auto& p : tokenize(parameter, ',')) {
+    if (p == "arena") {
+      result.arena = true;
+    } else {
+      throw std::runtime_error("unknown parameter: " + p);
+    }
+  }
+  return result;
+}
+
 void generate_service_header(const ServiceDescriptor* service,
+                             const Generator_options& options,
                              std::ostream& dst) {
  
   auto name = service->name();
@@ -147,8 +180,13 @@ void generate_service_header(const ServiceDescriptor* service,
 
     switch(get_mode(method)) {
       case Method_mode::UNARY:
-        dst << "  virtual ::easy_grpc::Future<" << class_name(output) << "> "
-            << method->name() << "(" << class_name(input) << ") = 0;\n";
+        if (options.arena) {
+          dst << "  virtual ::easy_grpc::Future<void> " << method->name()
+              << "(const " << class_name(input) << "&, " << class_name(output) << "&) = 0;\n";
+        } else {
+          dst << "  virtual ::easy_grpc::Future<" << class_name(output) << "> "
+              << method->name() << "(" << class_name(input) << ") = 0;\n";
+        }
         break;
       case Method_mode::CLIENT_STREAM:
         dst << "  virtual ::easy_grpc::Future<" << class_name(output) << "> "
@@ -183,6 +221,8 @@ void generate_service_header(const ServiceDescriptor* service,
       case Method_mode::CLIENT_STREAM:
         dst << "    virtual std::tuple<::easy_grpc::Stream_promise<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
           << method->name() << "(::easy_grpc::client::Call_options={}) = 0;\n";
+        dst << "    virtual std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
+          << method->name() << "(::easy_grpc::client::With_writer, ::easy_grpc::client::Call_options={}) = 0;\n";
         break;
       case Method_mode::SERVER_STREAM:
         dst << "    virtual ::easy_grpc::Stream_future<" << class_name(output) << "> "
@@ -192,6 +232,8 @@ void generate_service_header(const ServiceDescriptor* service,
       case Method_mode::BIDIR_STREAM:
         dst << "    virtual std::tuple<::easy_grpc::Stream_promise<"<< class_name(input)<<">, ::easy_grpc::Stream_future<" << class_name(output) << ">> "
           << method->name() << "(::easy_grpc::client::Call_options={}) = 0;\n";
+        dst << "    virtual std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Stream_future<" << class_name(output) << ">> "
+          << method->name() << "(::easy_grpc::client::With_writer, ::easy_grpc::client::Call_options={}) = 0;\n";
         break;
     }
   }
@@ -213,10 +255,15 @@ void generate_service_header(const ServiceDescriptor* service,
         dst << "    ::easy_grpc::Future<" << class_name(output) << "> "
           << method->name() << "(" << class_name(input)
           << ", ::easy_grpc::client::Call_options={}) override;\n";
+        dst << "    " << class_name(output) << " "
+          << method->name() << "_sync(" << class_name(input)
+          << ", const ::easy_grpc::client::Call_options& = {});\n";
         break;
       case Method_mode::CLIENT_STREAM:
         dst << "    std::tuple<::easy_grpc::Stream_promise<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
           << method->name() << "(::easy_grpc::client::Call_options={}) override;\n";
+        dst << "    std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
+          << method->name() << "(::easy_grpc::client::With_writer, ::easy_grpc::client::Call_options={}) override;\n";
         break;
       case Method_mode::SERVER_STREAM:
         dst << "    ::easy_grpc::Stream_future<" << class_name(output) << "> "
@@ -226,14 +273,32 @@ void generate_service_header(const ServiceDescriptor* service,
       case Method_mode::BIDIR_STREAM:
         dst << "    std::tuple<::easy_grpc::Stream_promise<"<< class_name(input)<<">, ::easy_grpc::Stream_future<" << class_name(output) << ">> "
           << method->name() << "(::easy_grpc::client::Call_options={}) override;\n";
+        dst << "    std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Stream_future<" << class_name(output) << ">> "
+          << method->name() << "(::easy_grpc::client::With_writer, ::easy_grpc::client::Call_options={}) override;\n";
         break;
     }
   }
 
   dst << "\n"
+      << "    // Hedges the unary calls made without a hedging policy of their own.\n"
+      << "    void set_hedging(std::shared_ptr<::easy_grpc::client::Hedging_policy> policy) { hedging_ = std::move(policy); }\n\n";
+
+  // Per-method retry policies, for unary methods only.
+  dst << "    struct Retry_policies {\n";
+  for (int i = 0; i < service->method_count(); ++i) {
+    auto method = service->method(i);
+    if (get_mode(method) == Method_mode::UNARY) {
+      dst << "      std::shared_ptr<const ::easy_grpc::client::Retry_policy> " << method->name() << ";\n";
+    }
+  }
+  dst << "    };\n\n"
+      << "    // Retries the unary calls made without a retry policy of their own.\n"
+      << "    void set_retry_policies(Retry_policies policies) { retry_policies_ = std::move(policies); }\n\n"
       << "  private:\n"
       << "    ::easy_grpc::client::Channel* channel_;\n"
-      << "    ::easy_grpc::Completion_queue* default_queue_;\n\n";
+      << "    ::easy_grpc::Completion_queue* default_queue_;\n"
+      << "    std::shared_ptr<::easy_grpc::client::Hedging_policy> hedging_;\n"
+      << "    Retry_policies retry_policies_;\n\n";
 
   for (int i = 0; i < service->method_count(); ++i) {
     auto method = service->method(i);
@@ -241,33 +306,85 @@ void generate_service_header(const ServiceDescriptor* service,
   }
   dst << "  };\n\n";
 
+  // Per-method queue assignment, methods left empty use the server's default queues.
+  dst << "  struct Method_queues {\n";
+  for (int i = 0; i < service->method_count(); ++i) {
+    auto method = service->method(i);
+    dst << "    ::easy_grpc::Completion_queue_set " << method->name() << ";\n";
+  }
+  dst << "  };\n\n";
+
+  // Implementations can take a Stream_writer for streamed replies, and a
+  // Call_context as last argument. Detect which flavor each method uses.
+  for (int i = 0; i < service->method_count(); ++i) {
+    auto method = service->method(i);
+
+    dst << "  template<typename ImplT, typename ArgsT, typename = void>\n"
+        << "  struct " << method->name() << "_accepts : std::false_type {};\n"
+        << "  template<typename ImplT, typename... ArgsT>\n"
+        << "  struct " << method->name() << "_accepts<ImplT, std::tuple<ArgsT...>, std::void_t<decltype(std::declval<ImplT&>()."
+        << method->name() << "(std::declval<ArgsT>()...))>> : std::true_type {};\n\n";
+  }
+
   dst << "  template<typename ImplT>\n"
-      << "  static ::easy_grpc::server::Service_config get_config(ImplT& impl) {\n"
+      << "  static ::easy_grpc::server::Service_config get_config(ImplT& impl, const Method_queues& queues = {}) {\n"
       << "    ::easy_grpc::server::Service_config result(\""<< full_name <<"\");\n\n";
   for (int i = 0; i < service->method_count(); ++i) {
     auto method = service->method(i);
     auto input = method->input_type();
     auto output = method->output_type();
 
-    switch(get_mode(method)) {
-    case Method_mode::UNARY:
-      dst << "    result.add_method("
-        << method_name_cste(method) << ", [&impl](" << class_name(input) << " req){return impl." << method->name() << "(std::move(req));});\n"; 
-      break;
-    case Method_mode::CLIENT_STREAM:
-      dst << "    result.add_method("
-        << method_name_cste(method) << ", [&impl](::easy_grpc::Stream_future<" << class_name(input) << "> req){return impl." << method->name() << "(std::move(req));});\n"; 
-      break;
-    case Method_mode::SERVER_STREAM:
-      dst << "    result.add_method("
-        << method_name_cste(method) << ", [&impl](" << class_name(input) << " req){return impl." << method->name() << "(std::move(req));});\n"; 
-      break;
-    case Method_mode::BIDIR_STREAM:
-      dst << "    result.add_method("
-        << method_name_cste(method) << ", [&impl](::easy_grpc::Stream_future<" << class_name(input) << "> req){return impl." << method->name() << "(std::move(req));});\n"; 
-      break;
+    std::vector<std::string> params;
+    auto mode = get_mode(method);
+    if (mode == Method_mode::UNARY && options.arena) {
+      params = {"const " + class_name(input) + "&", class_name(output) + "&"};
+    } else {
+      params = {request_type(method)};
+    }
+
+    // Each flavor, from the most specific to the least.
+    std::vector<std::vector<std::string>> flavors;
+    auto with_context = params;
+    with_context.push_back("const ::easy_grpc::server::Call_context&");
+    if (mode == Method_mode::SERVER_STREAM || mode == Method_mode::BIDIR_STREAM) {
+      auto with_writer = params;
+      with_writer.push_back(writer_type(method));
+      auto with_writer_and_context = with_writer;
+      with_writer_and_context.push_back(with_context.back());
+
+      flavors = {with_writer_and_context, with_writer, with_context, params};
+    } else {
+      flavors = {with_context, params};
     }
 
+    for (std::size_t f = 0; f < flavors.size(); ++f) {
+      const auto& args = flavors[f];
+      bool last = f + 1 == flavors.size();
+
+      std::string arg_types;
+      std::string lambda_params;
+      std::string call_args;
+      for (std::size_t a = 0; a < args.size(); ++a) {
+        auto arg_name = "a" + std::to_string(a);
+        auto sep = a == 0 ? "" : ", ";
+        arg_types += sep + args[a];
+        lambda_params += sep + args[a] + " " + arg_name;
+        // Arguments taken by value are moved along.
+        call_args += sep + (args[a].back() == '&' ? arg_name : "std::move(" + arg_name + ")");
+      }
+
+      if (f == 0) {
+        dst << "    if constexpr(" << method->name() << "_accepts<ImplT, std::tuple<" << arg_types << ">>::value) {\n";
+      } else if (!last) {
+        dst << "    else if constexpr(" << method->name() << "_accepts<ImplT, std::tuple<" << arg_types << ">>::value) {\n";
+      } else {
+        dst << "    else {\n";
+      }
+
+      dst << "      result.add_method(" << method_name_cste(method) << ", [&impl](" << lambda_params
+          << "){return impl." << method->name() << "(" << call_args << ");}, queues." << method->name() << ");\n"
+          << "    }\n";
+    }
   }
 
   dst << "\n    return result;\n";
@@ -320,10 +437,19 @@ void generate_service_source(const ServiceDescriptor* service,
         << " req, ::easy_grpc::client::Call_options options) {\n"
         << "  if(!options.completion_queue) { options.completion_queue = "
            "default_queue_; }\n"
+        << "  if(!options.hedging) { options.hedging = hedging_; }\n"
+        << "  if(!options.retry) { options.retry = retry_policies_." << method->name() << "; }\n"
         << "  return ::easy_grpc::client::start_unary_call<"
         << class_name(output) << ">(channel_, " << method->name()
         << "_tag_, std::move(req), std::move(options));\n"
         << "}\n\n";
+      dst << class_name(output) << " " << name
+        << "::Stub::" << method->name() << "_sync(" << class_name(input)
+        << " req, const ::easy_grpc::client::Call_options& options) {\n"
+        << "  return ::easy_grpc::client::call_unary_sync<"
+        << class_name(output) << ">(channel_, " << method->name()
+        << "_tag_, std::move(req), options);\n"
+        << "}\n\n";
       break;
     case Method_mode::CLIENT_STREAM:
       dst << "std::tuple<::easy_grpc::Stream_promise<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
@@ -335,6 +461,15 @@ void generate_service_source(const ServiceDescriptor* service,
           << class_name(input) << ">(channel_, " << method->name()
           << "_tag_, std::move(options));\n"
           << "}\n\n";
+      dst << "std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Future<" << class_name(output) << ">> "
+          << name << "::Stub::" << method->name() << "(::easy_grpc::client::With_writer w, ::easy_grpc::client::Call_options options) {\n";
+ 
+      dst << "  if(!options.completion_queue) { options.completion_queue = "
+           "default_queue_; }\n"
+          << "  return ::easy_grpc::client::start_client_streaming_call<" << class_name(output) << ", " 
+          << class_name(input) << ">(w, channel_, " << method->name()
+          << "_tag_, std::move(options));\n"
+          << "}\n\n";
       break;
     case Method_mode::SERVER_STREAM:
       dst << "::easy_grpc::Stream_future<" << class_name(output) << "> " << name
@@ -356,12 +491,21 @@ void generate_service_source(const ServiceDescriptor* service,
         << class_name(output) << ", " << class_name(input) << ">(channel_, " << method->name()
         << "_tag_, std::move(options));\n"
         << "}\n\n";
+      dst << "std::tuple<::easy_grpc::Stream_writer<"<< class_name(input)<<">, ::easy_grpc::Stream_future<" << class_name(output) << ">> " << name
+        << "::Stub::" << method->name() << "(::easy_grpc::client::With_writer w, ::easy_grpc::client::Call_options options) {\n"
+        << "  if(!options.completion_queue) { options.completion_queue = "
+           "default_queue_; }\n"
+        << "  return ::easy_grpc::client::start_bidir_streaming_call<"
+        << class_name(output) << ", " << class_name(input) << ">(w, channel_, " << method->name()
+        << "_tag_, std::move(options));\n"
+        << "}\n\n";
       break;
     }
   }
 }
 
-std::string generate_header(const FileDescriptor* file) {
+std::string generate_header(const FileDescriptor* file,
+                            const Generator_options& options) {
   std::ostringstream result;
 
   auto file_name = path(file->name()).stem().string();
@@ -393,7 +537,7 @@ std::string generate_header(const FileDescriptor* file) {
 
   // Services
   for (int i = 0; i < file->service_count(); ++i) {
-    generate_service_header(file->service(i), result);
+    generate_service_header(file->service(i), options, result);
   }
 
   // Epilogue
@@ -464,9 +608,10 @@ class Generator : public CodeGenerator {
                 GeneratorContext* context, std::string* error) const override {
     try {
       auto file_name = path(file->name()).stem().string();
+      auto options = parse_options(parameter);
 
       {
-        auto header_data = generate_header(file);
+        auto header_data = generate_header(file, options);
 
         std::unique_ptr<ZeroCopyOutputStream> header_dst{
             context->Open(file_name + header_extension)};
@@ -0,0 +1,77 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/alarm.h"
+#include "easy_grpc/environment.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace easy_grpc {
+
+namespace {
+std::mutex alarm_mtx;
+std::unordered_set<Alarm*> alarms;
+}  // namespace
+
+// grpc's C API has no timers of its own, but a watch on a channel's
+// connectivity state completes on its queue at the watch's deadline if the
+// state has not changed by then. The alarm's channel is never asked to
+// connect, so it stays idle until it is destroyed, which ends the watch
+// right away. That's why every alarm needs a channel of its own.
+Alarm::Alarm(Completion_queue* queue, gpr_timespec deadline,
+             Completion_tag tag)
+    : queue_(queue) {
+  Environment::assert_valid();
+
+  channel_ = grpc_insecure_channel_create("easy_grpc.alarm.invalid:1", nullptr,
+                                          nullptr);
+
+  std::lock_guard l(alarm_mtx);
+  alarms.insert(this);
+  grpc_channel_watch_connectivity_state(channel_, GRPC_CHANNEL_IDLE, deadline,
+                                        queue->handle(), tag.data);
+}
+
+Alarm::~Alarm() {
+  std::lock_guard l(alarm_mtx);
+  alarms.erase(this);
+  cancel_();
+}
+
+void Alarm::cancel() {
+  std::lock_guard l(alarm_mtx);
+  cancel_();
+}
+
+void Alarm::cancel_() {
+  if (channel_) {
+    cancelled_ = true;
+    grpc_channel_destroy(channel_);
+    channel_ = nullptr;
+  }
+}
+
+namespace detail {
+void cancel_alarms(Completion_queue* queue) {
+  std::lock_guard l(alarm_mtx);
+  for (auto alarm : alarms) {
+    if (!queue || alarm->queue_ == queue) {
+      alarm->cancel_();
+    }
+  }
+}
+}  // namespace detail
+
+}  // namespace easy_grpc
@@ -0,0 +1,120 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/channel_args.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace easy_grpc {
+
+namespace {
+int to_ms(std::chrono::milliseconds duration) {
+  if (duration.count() < 0 ||
+      duration.count() > std::numeric_limits<int>::max()) {
+    throw std::invalid_argument("duration out of range for a channel arg");
+  }
+  return static_cast<int>(duration.count());
+}
+}  // namespace
+
+Channel_args& Channel_args::max_receive_message_size(int size) {
+  return set(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH, size);
+}
+
+Channel_args& Channel_args::max_send_message_size(int size) {
+  return set(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH, size);
+}
+
+Channel_args& Channel_args::stream_window_size(int size) {
+  return set(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, size);
+}
+
+Channel_args& Channel_args::bdp_probe(bool enabled) {
+  return set(GRPC_ARG_HTTP2_BDP_PROBE, enabled ? 1 : 0);
+}
+
+Channel_args& Channel_args::write_buffer_size(int size) {
+  return set(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE, size);
+}
+
+Channel_args& Channel_args::max_frame_size(int size) {
+  return set(GRPC_ARG_HTTP2_MAX_FRAME_SIZE, size);
+}
+
+Channel_args& Channel_args::keepalive(std::chrono::milliseconds time,
+                                      std::chrono::milliseconds timeout,
+                                      bool permit_without_calls) {
+  set(GRPC_ARG_KEEPALIVE_TIME_MS, to_ms(time));
+  set(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, to_ms(timeout));
+  return set(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS,
+             permit_without_calls ? 1 : 0);
+}
+
+Channel_args& Channel_args::max_concurrent_streams(int count) {
+  return set(GRPC_ARG_MAX_CONCURRENT_STREAMS, count);
+}
+
+Channel_args& Channel_args::compression(const Compression_options& options) {
+  if (options.algorithm) {
+    set(GRPC_COMPRESSION_CHANNEL_DEFAULT_ALGORITHM, *options.algorithm);
+  }
+  if (options.level) {
+    set(GRPC_COMPRESSION_CHANNEL_DEFAULT_LEVEL, *options.level);
+  }
+  return *this;
+}
+
+Channel_args& Channel_args::set(std::string key, int value) {
+  values_[std::move(key)] = value;
+  return *this;
+}
+
+Channel_args& Channel_args::set(std::string key, std::string value) {
+  values_[std::move(key)] = std::move(value);
+  return *this;
+}
+
+Channel_args& Channel_args::merge(const Channel_args& other) {
+  for (const auto& [key, value] : other.values_) {
+    values_[key] = value;
+  }
+  return *this;
+}
+
+const Channel_args::Value* Channel_args::find(const std::string& key) const {
+  auto found = values_.find(key);
+  return found == values_.end() ? nullptr : &found->second;
+}
+
+std::vector<grpc_arg> Channel_args::to_grpc() const {
+  std::vector<grpc_arg> result;
+  result.reserve(values_.size());
+
+  for (const auto& [key, value] : values_) {
+    grpc_arg arg;
+    arg.key = const_cast<char*>(key.c_str());
+    if (auto integer = std::get_if<int>(&value)) {
+      arg.type = GRPC_ARG_INTEGER;
+      arg.value.integer = *integer;
+    } else {
+      arg.type = GRPC_ARG_STRING;
+      arg.value.string = const_cast<char*>(std::get<std::string>(value).c_str());
+    }
+    result.push_back(arg);
+  }
+  return result;
+}
+
+}  // namespace easy_grpc
@@ -0,0 +1,134 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/balanced_channel.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace easy_grpc {
+namespace client {
+
+namespace {
+std::vector<Balanced_channel::Endpoint_config> configs(
+    const std::vector<std::string>& addresses, const Channel_args& args) {
+  std::vector<Balanced_channel::Endpoint_config> result;
+  for (const auto& addr : addresses) {
+    result.push_back({addr, args});
+  }
+  return result;
+}
+}  // namespace
+
+Balanced_channel::Balanced_channel(const std::vector<std::string>& addresses,
+                                   Completion_queue* default_pool,
+                                   std::unique_ptr<Balancing_policy> policy,
+                                   const Channel_args& args)
+    : Balanced_channel(configs(addresses, args), default_pool,
+                       std::move(policy)) {}
+
+Balanced_channel::Balanced_channel(
+    const std::vector<Endpoint_config>& endpoints,
+    Completion_queue* default_pool, std::unique_ptr<Balancing_policy> policy)
+    : Channel(nullptr, default_pool), policy_(std::move(policy)) {
+  if (endpoints.empty()) {
+    throw std::invalid_argument("Balanced_channel needs at least one endpoint");
+  }
+  if (!policy_) {
+    policy_ = std::make_unique<Round_robin_policy>();
+  }
+
+  for (const auto& endpoint : endpoints) {
+    auto grpc_args = endpoint.args.to_grpc();
+    grpc_channel_args channel_args{grpc_args.size(), grpc_args.data()};
+
+    endpoints_.push_back(
+        {endpoint.address,
+         grpc_insecure_channel_create(endpoint.address.c_str(), &channel_args,
+                                      nullptr),
+         std::make_shared<std::atomic<std::size_t>>(0)});
+  }
+
+  policy_->init(*this);
+}
+
+Balanced_channel::~Balanced_channel() {
+  retire();
+  for (auto& endpoint : endpoints_) {
+    grpc_channel_destroy(endpoint.handle);
+  }
+}
+
+void* Balanced_channel::register_method(const char* name) {
+  std::vector<void*> tags;
+  tags.reserve(endpoints_.size());
+  for (auto& endpoint : endpoints_) {
+    tags.push_back(
+        grpc_channel_register_call(endpoint.handle, name, nullptr, nullptr));
+  }
+
+  std::lock_guard l(methods_mtx_);
+  methods_.push_back(std::move(tags));
+  return &methods_.back();
+}
+
+Channel_call Balanced_channel::create_call(void* method_tag,
+                                           const Call_options& options,
+                                           grpc_completion_queue* queue,
+                                           std::size_t exclude) {
+  const auto& tags = *static_cast<std::vector<void*>*>(method_tag);
+  auto index = policy_->pick(*this, options, exclude);
+  auto& endpoint = endpoints_[index];
+
+  return {grpc_channel_create_registered_call(
+              endpoint.handle, nullptr, GRPC_PROPAGATE_DEFAULTS, queue,
+              tags[index], options.deadline, nullptr),
+          In_flight_token(endpoint.in_flight), index};
+}
+
+const std::string& Balanced_channel::address(std::size_t index) const {
+  return endpoints_.at(index).address;
+}
+
+std::size_t Balanced_channel::in_flight(std::size_t index) const {
+  return *endpoints_.at(index).in_flight;
+}
+
+std::vector<std::string> parse_address_list(const std::string& list) {
+  // grpc's static resolver form, "ipv4:addr1,addr2", names the scheme once
+  // for the whole list.
+  std::string scheme;
+  for (const char* candidate : {"ipv4:", "ipv6:"}) {
+    if (list.compare(0, 5, candidate) == 0) {
+      scheme = candidate;
+    }
+  }
+
+  std::vector<std::string> result;
+  std::size_t begin = scheme.size();
+  while (begin <= list.size()) {
+    auto end = std::min(list.find(',', begin), list.size());
+    auto first = list.find_first_not_of(" \t", begin);
+    auto last = list.find_last_not_of(" \t", end - 1);
+    if (first >= end || last == std::string::npos || last < first) {
+      throw std::invalid_argument("empty address in list: " + list);
+    }
+    result.push_back(scheme + list.substr(first, last - first + 1));
+    begin = end + 1;
+  }
+  return result;
+}
+
+}  // namespace client
+}  // namespace easy_grpc
@@ -0,0 +1,140 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/balancing_policy.h"
+#include "easy_grpc/client/balanced_channel.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+namespace easy_grpc {
+namespace client {
+
+namespace {
+// FNV-1a, so that every client process agrees on where a key goes. Its high
+// bits barely change between strings that only differ at the end, like
+// "user-1" and "user-2", so the result goes through splitmix64's finalizer
+// before being placed on the ring.
+std::uint64_t hash(const std::string& data) {
+  std::uint64_t result = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    result ^= c;
+    result *= 1099511628211ULL;
+  }
+
+  result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  result = (result ^ (result >> 27)) * 0x94d049bb133111ebULL;
+  return result ^ (result >> 31);
+}
+}  // namespace
+
+std::size_t Round_robin_policy::pick(const Balanced_channel& channel,
+                                     const Call_options&,
+                                     std::size_t exclude) {
+  auto index = next_++ % channel.size();
+  if (index == exclude) {
+    index = (index + 1) % channel.size();
+  }
+  return index;
+}
+
+std::size_t Least_outstanding_policy::pick(const Balanced_channel& channel,
+                                           const Call_options&,
+                                           std::size_t exclude) {
+  auto start = next_++ % channel.size();
+  if (start == exclude) {
+    start = (start + 1) % channel.size();
+  }
+
+  auto best = start;
+  for (std::size_t i = 1; i < channel.size(); ++i) {
+    auto candidate = (start + i) % channel.size();
+    if (candidate != exclude &&
+        channel.in_flight(candidate) < channel.in_flight(best)) {
+      best = candidate;
+    }
+  }
+  return best;
+}
+
+std::size_t Power_of_two_choices_policy::pick(const Balanced_channel& channel,
+                                              const Call_options&,
+                                              std::size_t exclude) {
+  // Draws among the endpoints other than exclude, then maps the draws back to
+  // endpoint indices.
+  bool excluding = exclude < channel.size() && channel.size() > 1;
+  auto choices = channel.size() - (excluding ? 1 : 0);
+  auto endpoint = [&](std::size_t choice) {
+    return excluding && choice >= exclude ? choice + 1 : choice;
+  };
+
+  if (choices == 1) {
+    return endpoint(0);
+  }
+
+  thread_local std::minstd_rand rng{std::random_device{}()};
+  auto first = rng() % choices;
+  auto second = (first + 1 + rng() % (choices - 1)) % choices;
+  first = endpoint(first);
+  second = endpoint(second);
+  return channel.in_flight(second) < channel.in_flight(first) ? second : first;
+}
+
+Consistent_hash_policy::Consistent_hash_policy(std::size_t replicas)
+    : replicas_(std::max<std::size_t>(replicas, 1)) {}
+
+void Consistent_hash_policy::init(const Balanced_channel& channel) {
+  ring_.clear();
+  ring_.reserve(channel.size() * replicas_);
+  for (std::size_t i = 0; i < channel.size(); ++i) {
+    for (std::size_t r = 0; r < replicas_; ++r) {
+      ring_.emplace_back(hash(channel.address(i) + "#" + std::to_string(r)), i);
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+}
+
+std::size_t Consistent_hash_policy::pick(const Balanced_channel& channel,
+                                         const Call_options& options,
+                                         std::size_t exclude) {
+  if (options.balancing_key.empty()) {
+    auto index = next_++ % channel.size();
+    if (index == exclude) {
+      index = (index + 1) % channel.size();
+    }
+    return index;
+  }
+
+  auto point = std::lower_bound(
+      ring_.begin(), ring_.end(),
+      std::make_pair(hash(options.balancing_key), std::size_t(0)));
+  if (point == ring_.end()) {
+    point = ring_.begin();
+  }
+
+  // The key's next endpoint along the ring, so that its calls that avoid the
+  // same endpoint still agree on where to go.
+  if (point->second == exclude && channel.size() > 1) {
+    do {
+      if (++point == ring_.end()) {
+        point = ring_.begin();
+      }
+    } while (point->second == exclude);
+  }
+  return point->second;
+}
+
+}  // namespace client
+}  // namespace easy_grpc
@@ -0,0 +1,56 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/channel_pool.h"
+
+#include <stdexcept>
+
+namespace easy_grpc {
+namespace client {
+
+namespace {
+std::vector<Balanced_channel::Endpoint_config> members(
+    const std::string& addr, std::size_t size, const Channel_args& args) {
+  if (size == 0) {
+    throw std::invalid_argument("Channel_pool needs at least one channel");
+  }
+
+  std::vector<Balanced_channel::Endpoint_config> result;
+  for (std::size_t i = 0; i < size; ++i) {
+    // grpc would otherwise hand every channel to the same address the same
+    // subchannel, and with it the same connection.
+    result.push_back(
+        {addr, Channel_args(args)
+                   .set(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1)
+                   .set("easy_grpc.channel_pool_index", static_cast<int>(i))});
+  }
+  return result;
+}
+
+std::unique_ptr<Balancing_policy> make_policy(Channel_pool::Policy policy) {
+  if (policy == Channel_pool::Policy::least_outstanding) {
+    return std::make_unique<Least_outstanding_policy>();
+  }
+  return std::make_unique<Round_robin_policy>();
+}
+}  // namespace
+
+Channel_pool::Channel_pool(const std::string& addr,
+                           Completion_queue* default_pool, std::size_t size,
+                           Policy policy, const Channel_args& args)
+    : Balanced_channel(members(addr, size, args), default_pool,
+                       make_policy(policy)) {}
+
+}  // namespace client
+}  // namespace easy_grpc
@@ -0,0 +1,55 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/hedging.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace easy_grpc {
+namespace client {
+
+Hedging_policy::Hedging_policy(std::chrono::milliseconds delay,
+                               double budget_ratio, double max_tokens)
+    : delay_(delay),
+      budget_ratio_(budget_ratio),
+      max_tokens_(max_tokens),
+      tokens_(max_tokens) {
+  if (delay.count() < 0 || budget_ratio < 0.0 || max_tokens < 1.0) {
+    throw std::invalid_argument(
+        "Hedging_policy needs delay >= 0, budget_ratio >= 0 and max_tokens >= "
+        "1");
+  }
+}
+
+void Hedging_policy::on_call() {
+  std::lock_guard l(mtx_);
+  tokens_ = std::min(max_tokens_, tokens_ + budget_ratio_);
+}
+
+bool Hedging_policy::try_hedge() {
+  {
+    std::lock_guard l(mtx_);
+    if (tokens_ >= 1.0) {
+      tokens_ -= 1.0;
+      ++stats_.hedges_issued;
+      return true;
+    }
+  }
+  ++stats_.hedges_throttled;
+  return false;
+}
+
+}  // namespace client
+}  // namespace easy_grpc
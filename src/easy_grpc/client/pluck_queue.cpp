@@ -0,0 +1,85 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/pluck_queue.h"
+#include "easy_grpc/environment.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace easy_grpc {
+namespace client {
+namespace detail {
+
+namespace {
+void destroy(grpc_completion_queue* queue) {
+  grpc_completion_queue_shutdown(queue);
+  grpc_completion_queue_destroy(queue);
+}
+
+class Thread_queue;
+
+// Queues must go before grpc does, which may well be before their thread
+// exits, so the Environment keeps track of them.
+std::mutex registry_mtx;
+std::unordered_set<Thread_queue*> registry;
+
+class Thread_queue {
+ public:
+  ~Thread_queue() {
+    std::lock_guard l(registry_mtx);
+    if (handle_) {
+      destroy(handle_);
+      registry.erase(this);
+    }
+  }
+
+  grpc_completion_queue* get() {
+    if (!handle_) {
+      std::lock_guard l(registry_mtx);
+      handle_ = grpc_completion_queue_create_for_pluck(nullptr);
+      registry.insert(this);
+    }
+    return handle_;
+  }
+
+  // Invoked with registry_mtx held.
+  void shutdown() {
+    destroy(handle_);
+    handle_ = nullptr;
+  }
+
+ private:
+  grpc_completion_queue* handle_ = nullptr;
+};
+}  // namespace
+
+grpc_completion_queue* thread_pluck_queue() {
+  Environment::assert_valid();
+
+  thread_local Thread_queue queue;
+  return queue.get();
+}
+
+void shutdown_pluck_queues() {
+  std::lock_guard l(registry_mtx);
+  for (auto queue : registry) {
+    queue->shutdown();
+  }
+  registry.clear();
+}
+
+}  // namespace detail
+}  // namespace client
+}  // namespace easy_grpc
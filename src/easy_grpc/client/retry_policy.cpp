@@ -0,0 +1,44 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/client/retry_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace easy_grpc {
+namespace client {
+
+bool Retry_policy::is_retryable(grpc_status_code code) const {
+  return std::find(retryable_codes.begin(), retryable_codes.end(), code) !=
+         retryable_codes.end();
+}
+
+std::chrono::milliseconds Retry_policy::backoff(std::size_t retry) const {
+  auto cap = std::min(
+      static_cast<double>(max_backoff.count()),
+      initial_backoff.count() *
+          std::pow(backoff_multiplier, static_cast<double>(retry) - 1.0));
+  if (cap <= 0.0) {
+    return std::chrono::milliseconds(0);
+  }
+
+  thread_local std::minstd_rand rng{std::random_device{}()};
+  std::uniform_real_distribution<double> jitter(0.0, cap);
+  return std::chrono::milliseconds(static_cast<long long>(jitter(rng)));
+}
+
+}  // namespace client
+}  // namespace easy_grpc
@@ -20,5 +20,25 @@ Unsecure_channel::Unsecure_channel(const std::string& addr,
                                    Completion_queue* default_pool)
     : Channel(grpc_insecure_channel_create(addr.c_str(), nullptr, nullptr),
               default_pool) {}
+
+namespace {
+grpc_channel* create_channel(const std::string& addr,
+                             const Channel_args& args) {
+  auto grpc_args = args.to_grpc();
+  grpc_channel_args channel_args{grpc_args.size(), grpc_args.data()};
+  return grpc_insecure_channel_create(addr.c_str(), &channel_args, nullptr);
+}
+}  // namespace
+
+Unsecure_channel::Unsecure_channel(const std::string& addr,
+                                   Completion_queue* default_pool,
+                                   const Channel_args& args)
+    : Channel(create_channel(addr, args), default_pool) {}
+
+Unsecure_channel::Unsecure_channel(const std::string& addr,
+                                   Completion_queue* default_pool,
+                                   const Compression_options& compression)
+    : Unsecure_channel(addr, default_pool,
+                       Channel_args().compression(compression)) {}
 }  // namespace client
 }  // namespace easy_grpc
@@ -13,19 +13,74 @@
 // limitations under the License.
 
 #include "easy_grpc/completion_queue.h"
+#include "easy_grpc/alarm.h"
 #include "easy_grpc/config.h"
 
 #include <cassert>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace easy_grpc {
-Completion_queue::Completion_queue()
+Completion_queue::Completion_queue() : Completion_queue(1) {}
+
+Completion_queue::Completion_queue(std::size_t thread_count,
+                                   std::vector<int> cpu_set)
     : handle_(grpc_completion_queue_create_for_next(nullptr)) {
-  thread_ = std::thread([this]() { worker_main(); });
+  if (thread_count == 0) {
+    grpc_completion_queue_destroy(handle_);
+    throw std::invalid_argument("Completion_queue needs at least one thread");
+  }
+
+  for (int cpu : cpu_set) {
+#ifdef __linux__
+    bool valid = cpu >= 0 && cpu < CPU_SETSIZE;
+#else
+    bool valid = cpu >= 0;
+#endif
+    if (!valid) {
+      grpc_completion_queue_destroy(handle_);
+      throw std::invalid_argument("Completion_queue cpu index out of range");
+    }
+  }
+
+  threads_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this]() { worker_main(); });
+  }
+
+#ifdef __linux__
+  for (std::size_t i = 0; i < threads_.size() && !cpu_set.empty(); ++i) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu_set[i % cpu_set.size()], &cpus);
+
+    auto err = pthread_setaffinity_np(threads_[i].native_handle(),
+                                      sizeof(cpu_set_t), &cpus);
+    if (err != 0) {
+      shutdown_();
+      throw std::system_error(err, std::system_category(),
+                              "failed to pin completion queue thread");
+    }
+  }
+#else
+  (void)cpu_set;
+#endif
 }
 
-Completion_queue::~Completion_queue() {
+Completion_queue::~Completion_queue() { shutdown_(); }
+
+void Completion_queue::shutdown_() {
+  // Pending alarms would hold the shutdown back until they go off.
+  detail::cancel_alarms(this);
   grpc_completion_queue_shutdown(handle_);
-  thread_.join();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
   grpc_completion_queue_destroy(handle_);
 }
 
@@ -44,7 +99,7 @@ void Completion_queue::worker_main() {
       static_assert(noexcept(completion->exec(event.success, flags)));
       bool kill = completion->exec(event.success, flags);
       if (kill) {
-        delete completion;
+        completion->release();
       }
     } else {
       assert(event.type == GRPC_QUEUE_SHUTDOWN);
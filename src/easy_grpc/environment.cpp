@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "easy_grpc/environment.h"
+#include "easy_grpc/alarm.h"
+#include "easy_grpc/client/pluck_queue.h"
 
 #include "grpc/grpc.h"
 
@@ -31,6 +33,8 @@ Environment::Environment() {
 Environment::~Environment() {
   if (singleton == this) {
     singleton = nullptr;
+    detail::cancel_alarms();
+    client::detail::shutdown_pluck_queues();
     grpc_shutdown();
   }
 }
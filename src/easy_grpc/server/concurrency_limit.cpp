@@ -0,0 +1,182 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/server/concurrency_limit.h"
+#include "easy_grpc/server/concurrency_limit_feature.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace easy_grpc {
+namespace server {
+
+Concurrency_limiter::Concurrency_limiter(std::size_t max_queued)
+    : max_queued_(max_queued) {}
+
+std::size_t Concurrency_limiter::in_flight() const {
+  std::lock_guard l(mtx_);
+  return in_flight_;
+}
+
+std::size_t Concurrency_limiter::queued() const {
+  std::lock_guard l(mtx_);
+  return queue_.size();
+}
+
+std::uint64_t Concurrency_limiter::rejected() const {
+  std::lock_guard l(mtx_);
+  return rejected_;
+}
+
+bool Concurrency_limiter::try_acquire() {
+  std::lock_guard l(mtx_);
+  // Queued calls go first.
+  if (!queue_.empty() || in_flight_ >= limit()) {
+    return false;
+  }
+  ++in_flight_;
+  return true;
+}
+
+bool Concurrency_limiter::enqueue(std::function<void()> start) {
+  {
+    std::lock_guard l(mtx_);
+    if (queue_.empty() && in_flight_ < limit()) {
+      ++in_flight_;
+    } else if (queue_.size() < max_queued_) {
+      queue_.push_back(std::move(start));
+      return true;
+    } else {
+      ++rejected_;
+      return false;
+    }
+  }
+
+  start();
+  return true;
+}
+
+void Concurrency_limiter::release(std::chrono::steady_clock::duration latency) {
+  on_call_done(latency);
+
+  std::vector<std::function<void()>> to_start;
+  {
+    std::lock_guard l(mtx_);
+    --in_flight_;
+    while (!queue_.empty() && in_flight_ < limit()) {
+      to_start.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+      ++in_flight_;
+    }
+  }
+
+  for (auto& start : to_start) {
+    start();
+  }
+}
+
+Concurrency_limit::Concurrency_limit(std::size_t max_in_flight,
+                                     std::size_t max_queued)
+    : Concurrency_limiter(max_queued), max_in_flight_(max_in_flight) {
+  if (max_in_flight == 0) {
+    throw std::invalid_argument(
+        "Concurrency_limit needs to let at least one call through");
+  }
+}
+
+Adaptive_concurrency_limit::Adaptive_concurrency_limit(
+    Adaptive_limit_options options)
+    : Concurrency_limiter(options.max_queued),
+      options_(options),
+      limit_(options.initial_limit),
+      estimate_(static_cast<double>(options.initial_limit)) {
+  if (options.min_limit == 0 || options.initial_limit < options.min_limit ||
+      options.initial_limit > options.max_limit) {
+    throw std::invalid_argument(
+        "Adaptive_concurrency_limit needs 0 < min_limit <= initial_limit <= "
+        "max_limit");
+  }
+  if (options.backoff_ratio <= 0.0 || options.backoff_ratio >= 1.0) {
+    throw std::invalid_argument(
+        "Adaptive_concurrency_limit needs a backoff_ratio between 0 and 1");
+  }
+}
+
+std::uint64_t Adaptive_concurrency_limit::backoffs() const {
+  std::lock_guard l(estimate_mtx_);
+  return backoffs_;
+}
+
+void Adaptive_concurrency_limit::on_call_done(
+    std::chrono::steady_clock::duration latency) {
+  auto now = std::chrono::steady_clock::now();
+  // An idle method says nothing about how much more it could take.
+  bool in_use = in_flight() * 2 >= limit_;
+
+  std::lock_guard l(estimate_mtx_);
+  if (latency > options_.latency_threshold) {
+    if (now - latency >= last_backoff_) {
+      estimate_ = std::max(static_cast<double>(options_.min_limit),
+                           estimate_ * options_.backoff_ratio);
+      last_backoff_ = now;
+      ++backoffs_;
+    }
+  } else if (in_use) {
+    estimate_ = std::min(static_cast<double>(options_.max_limit),
+                         estimate_ + 1.0 / estimate_);
+  }
+  limit_ = static_cast<std::size_t>(estimate_);
+}
+
+Concurrency_limit_feature::Concurrency_limit_feature(Factory make_limiter,
+                                                     Scope scope)
+    : make_limiter_(std::move(make_limiter)), scope_(scope) {}
+
+Concurrency_limit_feature::Concurrency_limit_feature(std::size_t max_in_flight,
+                                                     std::size_t max_queued,
+                                                     Scope scope)
+    : Concurrency_limit_feature(
+          [max_in_flight, max_queued]() {
+            return std::make_shared<Concurrency_limit>(max_in_flight,
+                                                       max_queued);
+          },
+          scope) {}
+
+void Concurrency_limit_feature::add_to_config(Config& cfg) {
+  for (const auto& service : cfg.get_services()) {
+    std::shared_ptr<Concurrency_limiter> service_limiter;
+
+    for (const auto& method : service.methods()) {
+      auto options = method->options();
+      // Limits set explicitly on a method win.
+      if (options.concurrency_limit) {
+        continue;
+      }
+
+      if (scope_ == Scope::method) {
+        options.concurrency_limit = make_limiter_();
+      } else {
+        if (!service_limiter) {
+          service_limiter = make_limiter_();
+        }
+        options.concurrency_limit = service_limiter;
+      }
+      method->set_options(std::move(options));
+    }
+  }
+}
+
+}  // namespace server
+}  // namespace easy_grpc
@@ -57,6 +57,37 @@ Config&& Config::add_listening_port(std::string addr,
   return std::move(*this);
 }
 
+Config& Config::set_default_compression(Compression_options options) & {
+  args_.compression(options);
+  return *this;
+}
+
+Config&& Config::set_default_compression(Compression_options options) && {
+  args_.compression(options);
+  return std::move(*this);
+}
+
+Config& Config::add_channel_args(const Channel_args& args) & {
+  args_.merge(args);
+  return *this;
+}
+
+Config&& Config::add_channel_args(const Channel_args& args) && {
+  args_.merge(args);
+  return std::move(*this);
+}
+
+Config& Config::set_shutdown_grace_period(std::chrono::milliseconds period) & {
+  shutdown_grace_period_ = period;
+  return *this;
+}
+
+Config&& Config::set_shutdown_grace_period(
+    std::chrono::milliseconds period) && {
+  shutdown_grace_period_ = period;
+  return std::move(*this);
+}
+
 const std::vector<Service_config>& Config::get_services() const {
   return service_cfgs_;
 }
@@ -17,6 +17,7 @@
 #include "easy_grpc/server/service_impl.h"
 
 #include <cassert>
+#include <chrono>
 #include <set>
 
 namespace easy_grpc {
@@ -25,6 +26,7 @@ namespace server {
 
 Server::Server(Config cfg) 
   : default_queues_(cfg.default_queues_)
+  , shutdown_grace_period_(cfg.shutdown_grace_period_)
   , features_(std::move(cfg.features_)) {
   // We need to pre-allocate the shutdown queue. Because it must be registered
   // in the server prior to starting it.
@@ -45,7 +47,10 @@ Server::Server(Config cfg)
       grpc_completion_queue_factory_lookup(&sd_queue_attribs),
       &sd_queue_attribs, nullptr);
 
-  impl_ = grpc_server_create(nullptr, nullptr);
+  auto args = cfg.args_.to_grpc();
+  grpc_channel_args server_args{args.size(), args.data()};
+
+  impl_ = grpc_server_create(&server_args, nullptr);
 
   add_listening_ports_(cfg);
 
@@ -59,6 +64,8 @@ Server::Server(Config cfg)
     for (const auto& method_ptr : service.methods()) {
       auto method = method_ptr.get();
       all_methods.emplace_back(method, nullptr);
+      method_stats_[method->name()] = method->stats();
+      method_drains_.push_back(method->drain());
 
       auto queues = method->queues();
       if (queues.empty()) {
@@ -123,7 +130,11 @@ void Server::add_listening_ports_(const Config& cfg) {
 Server::~Server() { cleanup_(); }
 
 Server::Server(Server&& rhs)
-    : impl_(rhs.impl_), shutdown_queue_(rhs.shutdown_queue_) {
+    : impl_(rhs.impl_),
+      shutdown_queue_(rhs.shutdown_queue_),
+      shutdown_grace_period_(rhs.shutdown_grace_period_),
+      method_stats_(std::move(rhs.method_stats_)),
+      method_drains_(std::move(rhs.method_drains_)) {
   rhs.impl_ = nullptr;
   rhs.shutdown_queue_ = nullptr;
 }
@@ -132,6 +143,9 @@ Server& Server::operator=(Server&& rhs) {
   cleanup_();
   impl_ = rhs.impl_;
   shutdown_queue_ = rhs.shutdown_queue_;
+  shutdown_grace_period_ = rhs.shutdown_grace_period_;
+  method_stats_ = std::move(rhs.method_stats_);
+  method_drains_ = std::move(rhs.method_drains_);
 
   rhs.shutdown_queue_ = nullptr;
   rhs.impl_ = nullptr;
@@ -139,10 +153,23 @@ Server& Server::operator=(Server&& rhs) {
   return *this;
 }
 
+std::shared_ptr<const Method_stats> Server::method_stats(
+    const std::string& name) const {
+  auto found = method_stats_.find(name);
+  if (found == method_stats_.end()) {
+    return nullptr;
+  }
+  return found->second;
+}
+
 void Server::cleanup_() {
   if (impl_) {
     // Perform a synchronous server shutdown.
     grpc_server_shutdown_and_notify(impl_, shutdown_queue_, nullptr);
+
+    // Otherwise, calls whose handler never replies hold up the shutdown forever.
+    grpc_server_cancel_all_calls(impl_);
+
     auto evt = grpc_completion_queue_next(
         shutdown_queue_, gpr_inf_future(GPR_CLOCK_REALTIME), nullptr);
     assert(evt.type == GRPC_OP_COMPLETE);
@@ -154,6 +181,29 @@ void Server::cleanup_() {
     assert(evt.type == GRPC_QUEUE_SHUTDOWN);
     grpc_completion_queue_destroy(shutdown_queue_);
 
+    // grpc considers a call over as soon as the client is gone, but its
+    // handler may still be about to start batches on the server's queues.
+    // These must not be shut down before that's done. Calls queued behind a
+    // concurrency limit count as in flight too, and get released as the
+    // cancelled calls ahead of them finish.
+    auto give_up_at = std::chrono::steady_clock::now() + shutdown_grace_period_;
+    bool drained = true;
+    for (const auto& drain : method_drains_) {
+      if (!drain->wait_until(give_up_at)) {
+        drained = false;
+        break;
+      }
+    }
+
+    // Handlers still running are waiting on something that did not finish
+    // in time. They are cut off from the server before it goes away, see
+    // ~Server().
+    if (!drained) {
+      for (const auto& drain : method_drains_) {
+        drain->abandon();
+      }
+    }
+
     // destroy the server.
     grpc_server_destroy(impl_);
   }
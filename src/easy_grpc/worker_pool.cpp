@@ -0,0 +1,91 @@
+// Copyright 2019 Age of Minds inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "easy_grpc/worker_pool.h"
+
+#include <stdexcept>
+
+namespace easy_grpc {
+Worker_pool::Worker_pool(std::size_t thread_count, std::size_t capacity)
+    : capacity_(capacity) {
+  if (thread_count == 0 || capacity == 0) {
+    throw std::invalid_argument(
+        "Worker_pool needs at least one thread and one queue slot");
+  }
+
+  threads_.reserve(thread_count);
+  running_workers_ = thread_count;
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this]() { worker_main(); });
+  }
+}
+
+Worker_pool::~Worker_pool() {
+  {
+    std::lock_guard l(mtx_);
+    stopping_ = true;
+  }
+  not_empty_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void Worker_pool::push(std::function<void()> task) {
+  if (!enqueue_(task)) {
+    task();
+  }
+}
+
+bool Worker_pool::try_push(std::function<void()> task) {
+  return enqueue_(task);
+}
+
+bool Worker_pool::enqueue_(std::function<void()>& task) {
+  {
+    std::lock_guard l(mtx_);
+    if (running_workers_ == 0) {
+      // Nothing would ever run it.
+      throw std::logic_error("task pushed to a stopped Worker_pool");
+    }
+    if (tasks_.size() >= capacity_) {
+      return false;
+    }
+    tasks_.push_back(std::move(task));
+  }
+  not_empty_.notify_one();
+  return true;
+}
+
+void Worker_pool::worker_main() {
+  while (1) {
+    std::function<void()> task;
+    {
+      std::unique_lock l(mtx_);
+      not_empty_.wait(l, [this] { return stopping_ || !tasks_.empty(); });
+
+      if (tasks_.empty()) {
+        --running_workers_;
+        break;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+}  // namespace easy_grpc
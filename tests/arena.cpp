@@ -0,0 +1,104 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace rpc = easy_grpc;
+
+namespace {
+struct Fixture {
+  explicit Fixture(rpc::server::Service_config service)
+      : server_(rpc::server::Config()
+                    .add_default_listening_queues(
+                        {&server_queue_, &server_queue_ + 1})
+                    .add_service(std::move(service))
+                    .add_listening_port("127.0.0.1:0", {}, &server_port_)),
+        channel_(std::string("127.0.0.1:") + std::to_string(server_port_),
+                 &client_queue_),
+        stub(&channel_) {}
+
+ private:
+  rpc::Environment env_;
+  rpc::Completion_queue server_queue_;
+  rpc::Completion_queue client_queue_;
+  int server_port_ = 0;
+  rpc::server::Server server_;
+  rpc::client::Unsecure_channel channel_;
+
+ public:
+  tests::TestService::Stub stub;
+};
+}  // namespace
+
+TEST(arena, sync_handler) {
+  std::atomic<int> on_arena = 0;
+
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [&](const ::tests::TestRequest& req, ::tests::TestReply& rep) {
+        if (req.GetArena() && rep.GetArena() == req.GetArena()) {
+          ++on_arena;
+        }
+        rep.set_name(req.name() + "_replied");
+      });
+
+  Fixture fixture(std::move(service));
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  constexpr int call_count = 100;
+  for (int i = 0; i < call_count; ++i) {
+    EXPECT_EQ(fixture.stub.TestMethod(req).get().name(), "dude_replied");
+  }
+
+  EXPECT_EQ(on_arena.load(), call_count);
+}
+
+TEST(arena, async_handler) {
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [](const ::tests::TestRequest& req, ::tests::TestReply& rep) {
+        rep.set_name(req.name() + "_replied");
+        rep.set_count(static_cast<int>(req.name().size()));
+
+        rpc::Promise<void> done;
+        auto result = done.get_future();
+        done.set_value();
+        return result;
+      });
+
+  Fixture fixture(std::move(service));
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  auto rep = fixture.stub.TestMethod(req).get();
+  EXPECT_EQ(rep.name(), "dude_replied");
+  EXPECT_EQ(rep.count(), 4);
+}
+
+TEST(arena, failing_handler) {
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [](const ::tests::TestRequest& req, ::tests::TestReply&) {
+        if (req.name() == "fail") {
+          throw rpc::error::unimplemented("not done");
+        }
+      });
+
+  Fixture fixture(std::move(service));
+
+  ::tests::TestRequest req;
+  req.set_name("fail");
+  EXPECT_THROW(fixture.stub.TestMethod(req).get(), rpc::Rpc_error);
+
+  // The recycled handler must not carry anything over from the failed call.
+  req.set_name("fine");
+  EXPECT_EQ(fixture.stub.TestMethod(req).get().name(), "");
+}
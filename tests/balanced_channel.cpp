@@ -0,0 +1,187 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// A few servers on loopback, each answering with its own index.
+class Replicas {
+ public:
+  Replicas(std::size_t count, bool hold = false) {
+    for (std::size_t i = 0; i < count; ++i) {
+      rpc::server::Service_config service("test.Replica");
+      service.add_method("/test.Replica/Whoami", [this, i, hold](std::string) {
+        std::lock_guard l(mtx_);
+        held_.emplace_back();
+        auto result = held_.back().get_future();
+        if (!hold) {
+          held_.back().set_value(std::to_string(i));
+          held_.pop_back();
+        } else {
+          held_index_.push_back(i);
+        }
+        return result;
+      });
+      rpc::server::Method_options options;
+      options.listener_depth = 16;
+      service.set_method_options(options);
+
+      int port = 0;
+      servers_.push_back(std::make_unique<rpc::server::Server>(
+          rpc::server::Config()
+              .add_default_listening_queues({&queue_, &queue_ + 1})
+              .add_service(std::move(service))
+              .add_listening_port("127.0.0.1:0", {}, &port)));
+      addresses_.push_back("127.0.0.1:" + std::to_string(port));
+    }
+  }
+
+  const std::vector<std::string>& addresses() const { return addresses_; }
+
+  std::size_t held() {
+    std::lock_guard l(mtx_);
+    return held_.size();
+  }
+
+  void release() {
+    std::lock_guard l(mtx_);
+    for (std::size_t i = 0; i < held_.size(); ++i) {
+      held_[i].set_value(std::to_string(held_index_[i]));
+    }
+    held_.clear();
+    held_index_.clear();
+  }
+
+ private:
+  rpc::Completion_queue queue_;
+  std::vector<std::string> addresses_;
+
+  std::mutex mtx_;
+  std::vector<rpc::Promise<std::string>> held_;
+  std::vector<std::size_t> held_index_;
+
+  std::vector<std::unique_ptr<rpc::server::Server>> servers_;
+};
+
+void wait_until(const std::function<bool()>& condition) {
+  while (!condition()) {
+    std::this_thread::yield();
+  }
+}
+}  // namespace
+
+TEST(balanced_channel, round_robin) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Replicas replicas(3);
+
+  // grpc's static resolver form.
+  std::string list = "ipv4:";
+  for (const auto& addr : replicas.addresses()) {
+    list += addr + ",";
+  }
+  list.pop_back();
+
+  rpc::client::Balanced_channel channel(
+      rpc::client::parse_address_list(list), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", &channel);
+
+  std::vector<int> hits(3);
+  for (int i = 0; i < 9; ++i) {
+    ++hits.at(std::stoi(whoami("").get()));
+  }
+  EXPECT_EQ(hits, std::vector<int>({3, 3, 3}));
+}
+
+TEST(balanced_channel, power_of_two_choices) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Replicas replicas(3, true);
+
+  rpc::client::Balanced_channel channel(
+      replicas.addresses(), &client_queue,
+      std::make_unique<rpc::client::Power_of_two_choices_policy>());
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", &channel);
+
+  std::vector<rpc::Future<std::string>> replies;
+  for (int i = 0; i < 30; ++i) {
+    replies.push_back(whoami(""));
+  }
+
+  // The most loaded endpoint never gets a call while it is ahead of all the
+  // others, so none of them gets far ahead.
+  for (std::size_t i = 0; i < channel.size(); ++i) {
+    EXPECT_GE(channel.in_flight(i), 7U);
+    EXPECT_LE(channel.in_flight(i), 13U);
+  }
+
+  wait_until([&] { return replicas.held() == 30; });
+  replicas.release();
+  for (auto& rep : replies) {
+    rep.get();
+  }
+}
+
+TEST(balanced_channel, consistent_hash) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Replicas replicas(3);
+
+  rpc::client::Balanced_channel all(
+      replicas.addresses(), &client_queue,
+      std::make_unique<rpc::client::Consistent_hash_policy>());
+  rpc::client::Method_stub<std::string, std::string> whoami_all(
+      "/test.Replica/Whoami", &all);
+
+  // Same as all, minus the last replica.
+  rpc::client::Balanced_channel fewer(
+      {replicas.addresses()[0], replicas.addresses()[1]}, &client_queue,
+      std::make_unique<rpc::client::Consistent_hash_policy>());
+  rpc::client::Method_stub<std::string, std::string> whoami_fewer(
+      "/test.Replica/Whoami", &fewer);
+
+  std::vector<int> hits(3);
+  for (int i = 0; i < 60; ++i) {
+    rpc::client::Call_options options;
+    options.balancing_key = "user-" + std::to_string(i);
+
+    auto replica = whoami_all("", options).get();
+    ++hits.at(std::stoi(replica));
+    EXPECT_EQ(whoami_all("", options).get(), replica);
+
+    // Only the keys of the missing replica move.
+    if (replica != "2") {
+      EXPECT_EQ(whoami_fewer("", options).get(), replica);
+    }
+  }
+  for (auto count : hits) {
+    EXPECT_GT(count, 0);
+  }
+
+  // Calls without a key still go through.
+  EXPECT_NO_THROW(whoami_all("").get());
+}
+
+TEST(balanced_channel, parse_address_list) {
+  using rpc::client::parse_address_list;
+
+  EXPECT_EQ(parse_address_list("a:1"), std::vector<std::string>({"a:1"}));
+  EXPECT_EQ(parse_address_list("a:1, b:2"),
+            std::vector<std::string>({"a:1", "b:2"}));
+  EXPECT_EQ(parse_address_list("ipv4:10.0.0.1:1,10.0.0.2:2"),
+            std::vector<std::string>({"ipv4:10.0.0.1:1", "ipv4:10.0.0.2:2"}));
+
+  EXPECT_THROW(parse_address_list(""), std::invalid_argument);
+  EXPECT_THROW(parse_address_list("a:1,,b:2"), std::invalid_argument);
+  EXPECT_THROW(parse_address_list("a:1,"), std::invalid_argument);
+}
@@ -29,6 +29,27 @@ class Test_async_impl {
     return rep_fut;
   }
 };
+
+class Test_writer_impl {
+ public:
+  using service_type = tests::TestBidirStreamingService;
+
+  void TestMethod(::rpc::Stream_future<::tests::TestRequest> req,
+                  ::rpc::Stream_writer<::tests::TestReply> rep) {
+    req.for_each([rep](::tests::TestRequest r) mutable {
+      ::tests::TestReply reply;
+      reply.set_name(r.name());
+      rep.push(reply);
+    }).finally([rep](aom::expected<void> status) mutable {
+      if(status.has_value()) {
+        rep.complete();
+      }
+      else {
+        rep.set_exception(status.error());
+      }
+    });
+  }
+};
 }
 
 TEST(bidir_streaming, simple_call) {
@@ -117,3 +138,145 @@ TEST(bidir_streaming, failing_call) {
 
   EXPECT_THROW(all_done.get(), rpc::Rpc_error);
 }
+
+TEST(bidir_streaming, writer) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_writer_impl srv;
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestBidirStreamingService::get_config(srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestBidirStreamingService::Stub stub(&channel);
+
+  auto [req_stream, rep_stream] = stub.TestMethod();
+
+  auto names = std::make_shared<std::string>();
+  auto all_done = rep_stream.for_each([names](::tests::TestReply rep){
+    *names += rep.name();
+  }).then([names](){
+    return *names;
+  });
+
+  ::tests::TestRequest req;
+  for(int i = 0 ; i < 6; ++i) {
+    req.set_name(std::to_string(i));
+    req_stream.push(req);
+  }
+  req_stream.complete();
+  EXPECT_EQ(all_done.get(), "012345");
+}
+
+// A writer taken by reference still makes a bidir method.
+TEST(bidir_streaming, writer_by_reference) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("tests.TestBidirStreamingService");
+  service.add_method(
+      "/tests.TestBidirStreamingService/TestMethod",
+      [](::rpc::Stream_future<::tests::TestRequest> req,
+         ::rpc::Stream_writer<::tests::TestReply>& rep) {
+        req.for_each([rep](::tests::TestRequest r) mutable {
+          ::tests::TestReply reply;
+          reply.set_name(r.name());
+          rep.push(reply);
+        }).finally([rep](aom::expected<void>) mutable {
+          rep.complete();
+        });
+      });
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestBidirStreamingService::Stub stub(&channel);
+
+  auto [req_stream, rep_stream] = stub.TestMethod();
+
+  auto names = std::make_shared<std::string>();
+  auto all_done = rep_stream.for_each([names](::tests::TestReply rep){
+    *names += rep.name();
+  }).then([names](){
+    return *names;
+  });
+
+  ::tests::TestRequest req;
+  for(int i = 0 ; i < 3; ++i) {
+    req.set_name(std::to_string(i));
+    req_stream.push(req);
+  }
+  req_stream.complete();
+  EXPECT_EQ(all_done.get(), "012");
+}
+
+// Requests written through a bounded writer, which cancels the call once it
+// is dropped without being completed.
+TEST(bidir_streaming, client_writer) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_async_impl async_srv;
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestBidirStreamingService::get_config(async_srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestBidirStreamingService::Stub stub(&channel);
+
+  rpc::client::Call_options options;
+  options.stream_capacity = 2;
+
+  auto [writer, rep_stream] = stub.TestMethod(rpc::client::with_writer, options);
+  EXPECT_EQ(writer.capacity(), 2U);
+
+  auto count = std::make_shared<int>(0);
+  auto all_done = rep_stream.for_each([count](::tests::TestReply){
+    ++*count;
+  }).then([count](){
+    return *count;
+  });
+
+  for(int i = 0 ; i < 6; ++i) {
+    writer.ready().get();
+    writer.push({});
+  }
+  writer.complete();
+  EXPECT_EQ(all_done.get(), 6);
+
+  auto dropped = [&] {
+    auto [writer, rep_stream] = stub.TestMethod(rpc::client::with_writer);
+    writer.push({});
+    return rep_stream.for_each([](::tests::TestReply){});
+  }();
+  EXPECT_THROW(dropped.get(), rpc::Rpc_error);
+}
@@ -0,0 +1,79 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+TEST(bytes, string_is_adopted_when_moved) {
+  std::string data(4096, 'q');
+  auto storage = data.data();
+
+  auto buffer = rpc::serialize(std::move(data));
+  ASSERT_EQ(buffer->data.raw.slice_buffer.count, 1U);
+  EXPECT_EQ(GRPC_SLICE_START_PTR(buffer->data.raw.slice_buffer.slices[0]),
+            reinterpret_cast<std::uint8_t*>(storage));
+
+  EXPECT_EQ(rpc::deserialize<std::string>(buffer), std::string(4096, 'q'));
+  grpc_byte_buffer_destroy(buffer);
+}
+
+TEST(bytes, lvalues_are_copied) {
+  std::vector<std::uint8_t> data(4096, 3);
+
+  auto buffer = rpc::serialize(data);
+  EXPECT_EQ(data.size(), 4096U);
+  EXPECT_EQ(rpc::deserialize<std::vector<std::uint8_t>>(buffer), data);
+  grpc_byte_buffer_destroy(buffer);
+}
+
+TEST(bytes, byte_slice_references_payload) {
+  auto buffer = rpc::serialize(std::string(1000, 'x'));
+
+  auto received = rpc::deserialize<rpc::Byte_slice>(buffer);
+  EXPECT_EQ(received.data(), reinterpret_cast<const char*>(GRPC_SLICE_START_PTR(
+                                 buffer->data.raw.slice_buffer.slices[0])));
+  grpc_byte_buffer_destroy(buffer);
+
+  // Still valid after the buffer is gone.
+  EXPECT_EQ(received.view(), std::string(1000, 'x'));
+
+  auto copy = received;
+  EXPECT_EQ(copy.data(), received.data());
+
+  auto moved = std::move(copy);
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(moved.size(), 1000U);
+}
+
+TEST(bytes, end_to_end) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("test.Blobs");
+  service.add_method("/test.Blobs/Echo", [](rpc::Byte_slice req) {
+    return std::string(req.view()) + "!";
+  });
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  rpc::client::Method_stub<rpc::Byte_slice, std::string> echo(
+      "/test.Blobs/Echo", &channel);
+
+  EXPECT_EQ(echo(rpc::Byte_slice(std::string("hi"))).get(), "hi!");
+
+  std::string large(100000, 'b');
+  EXPECT_EQ(echo(rpc::Byte_slice(large)).get(), large + "!");
+}
@@ -0,0 +1,286 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace rpc = easy_grpc;
+
+namespace {
+gpr_timespec in_ms(int ms) {
+  return gpr_time_add(gpr_now(GPR_CLOCK_REALTIME),
+                      gpr_time_from_millis(ms, GPR_TIMESPAN));
+}
+
+struct Fixture {
+  explicit Fixture(rpc::server::Service_config service)
+      : server_(rpc::server::Config()
+                    .add_default_listening_queues(
+                        {&server_queue_, &server_queue_ + 1})
+                    .add_service(std::move(service))
+                    .add_listening_port("127.0.0.1:0", {}, &server_port_)),
+        channel(std::string("127.0.0.1:") + std::to_string(server_port_),
+                &client_queue_) {}
+
+ private:
+  rpc::Environment env_;
+  rpc::Completion_queue server_queue_;
+  rpc::Completion_queue client_queue_;
+  int server_port_ = 0;
+  rpc::server::Server server_;
+
+ public:
+  rpc::client::Unsecure_channel channel;
+};
+
+// Streams replies until the client goes away.
+class Endless_writer_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  ~Endless_writer_impl() {
+    if (producer_.joinable()) {
+      producer_.join();
+    }
+  }
+
+  void TestMethod(::tests::TestRequest,
+                  ::rpc::Stream_writer<::tests::TestReply> rep,
+                  const ::rpc::server::Call_context& ctx) {
+    producer_ = std::thread([this, rep, ctx]() mutable {
+      ::tests::TestReply msg;
+      try {
+        while (!ctx.cancelled()) {
+          rep.ready().get();
+          rep.push(msg);
+        }
+      } catch (...) {
+      }
+      stopped.set_value();
+    });
+  }
+
+  std::promise<void> stopped;
+
+ private:
+  std::thread producer_;
+};
+}  // namespace
+
+TEST(call_context, deadline) {
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [](::tests::TestRequest, const rpc::server::Call_context& ctx) {
+        ::tests::TestReply rep;
+        if (ctx.deadline() == std::chrono::system_clock::time_point::max()) {
+          rep.set_name("none");
+        } else {
+          auto left = ctx.deadline() - std::chrono::system_clock::now();
+          rep.set_count(static_cast<int>(
+              std::chrono::duration_cast<std::chrono::seconds>(left).count()));
+        }
+        EXPECT_FALSE(ctx.cancelled());
+        return rep;
+      });
+
+  Fixture fixture(std::move(service));
+  tests::TestService::Stub stub(&fixture.channel);
+
+  EXPECT_EQ(stub.TestMethod({}).get().name(), "none");
+
+  rpc::client::Call_options options;
+  options.deadline = in_ms(60000);
+  auto left = stub.TestMethod({}, options).get().count();
+  EXPECT_GT(left, 50);
+  EXPECT_LE(left, 60);
+}
+
+TEST(call_context, unary_cancelled_by_deadline) {
+  std::promise<void> noticed;
+
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [&](::tests::TestRequest, const rpc::server::Call_context& ctx) {
+        // Never replies on its own.
+        return ctx.on_cancel().then([&](bool cancelled) -> ::tests::TestReply {
+          EXPECT_TRUE(cancelled);
+          noticed.set_value();
+          throw rpc::error::cancelled("gave up");
+        });
+      });
+
+  Fixture fixture(std::move(service));
+  tests::TestService::Stub stub(&fixture.channel);
+
+  rpc::client::Call_options options;
+  options.deadline = in_ms(100);
+
+  try {
+    stub.TestMethod({}, options).get();
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_DEADLINE_EXCEEDED);
+  }
+
+  EXPECT_EQ(noticed.get_future().wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+}
+
+TEST(call_context, on_cancel_after_normal_completion) {
+  std::promise<bool> ended;
+
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [&](::tests::TestRequest, const rpc::server::Call_context& ctx) {
+        ctx.on_cancel().finally([&](rpc::expected<bool> cancelled) {
+          ended.set_value(cancelled.has_value() && cancelled.value());
+        });
+        return ::tests::TestReply{};
+      });
+
+  Fixture fixture(std::move(service));
+  tests::TestService::Stub stub(&fixture.channel);
+
+  stub.TestMethod({}).get();
+
+  auto result = ended.get_future();
+  ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_FALSE(result.get());
+}
+
+TEST(call_context, stream_stops_when_client_leaves) {
+  Endless_writer_impl srv;
+  auto stopped = srv.stopped.get_future();
+
+  Fixture fixture(tests::TestServerStreamingService::get_config(srv));
+  tests::TestServerStreamingService::Stub stub(&fixture.channel);
+
+  rpc::client::Call_options options;
+  options.deadline = in_ms(200);
+
+  auto received = std::make_shared<std::atomic<int>>(0);
+  auto done = stub.TestMethod({}, options).for_each(
+      [received](::tests::TestReply) { ++*received; });
+
+  EXPECT_THROW(done.get(), rpc::Rpc_error);
+  EXPECT_GT(received->load(), 0);
+  EXPECT_EQ(stopped.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+}
+
+TEST(call_context, client_streaming_cancel) {
+  std::promise<void> noticed;
+  std::promise<bool> requests_failed;
+
+  rpc::server::Service_config service("tests.TestClientStreamingService");
+  service.add_method(
+      tests::TestClientStreamingService::kTestClientStreamingService_TestMethod_name,
+      [&](rpc::Stream_future<::tests::TestRequest> reqs,
+          const rpc::server::Call_context& ctx) {
+        ctx.on_cancel().finally([&](rpc::expected<bool> cancelled) {
+          if (cancelled.has_value() && cancelled.value()) {
+            noticed.set_value();
+          }
+        });
+        return reqs.for_each([](::tests::TestRequest) {})
+            .then_expect([&](rpc::expected<void> status) {
+              requests_failed.set_value(!status.has_value());
+              return ::tests::TestReply{};
+            });
+      });
+
+  Fixture fixture(std::move(service));
+  tests::TestClientStreamingService::Stub stub(&fixture.channel);
+
+  auto [writer, reply] = stub.TestMethod();
+  writer.push(::tests::TestRequest{});
+  writer.set_exception(std::make_exception_ptr(std::runtime_error("nope")));
+
+  EXPECT_THROW(reply.get(), rpc::Rpc_error);
+  EXPECT_EQ(noticed.get_future().wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  auto failed = requests_failed.get_future();
+  ASSERT_EQ(failed.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_TRUE(failed.get());
+}
+
+TEST(call_context, stream_future_producer_stops) {
+  std::promise<void> stopped;
+  std::thread producer;
+
+  rpc::server::Service_config service("tests.TestServerStreamingService");
+  service.add_method(
+      tests::TestServerStreamingService::kTestServerStreamingService_TestMethod_name,
+      [&](::tests::TestRequest, const rpc::server::Call_context& ctx) {
+        ::rpc::Stream_promise<::tests::TestReply> rep;
+        auto result = rep.get_future();
+
+        // Nothing downstream can stop this loop: it has to watch the context.
+        producer = std::thread([&stopped, ctx, rep = std::move(rep)]() mutable {
+          while (!ctx.cancelled()) {
+            rep.push(::tests::TestReply{});
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+          rep.set_exception(
+              std::make_exception_ptr(rpc::error::cancelled("gave up")));
+          stopped.set_value();
+        });
+        return result;
+      });
+
+  {
+    Fixture fixture(std::move(service));
+    tests::TestServerStreamingService::Stub stub(&fixture.channel);
+
+    rpc::client::Call_options options;
+    options.deadline = in_ms(200);
+
+    auto done = stub.TestMethod({}, options).for_each([](::tests::TestReply) {});
+    EXPECT_THROW(done.get(), rpc::Rpc_error);
+    EXPECT_EQ(stopped.get_future().wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+  }
+  producer.join();
+}
+
+TEST(call_context, bidir_requests_fail_on_cancel) {
+  std::promise<bool> requests_failed;
+
+  rpc::server::Service_config service("tests.TestBidirStreamingService");
+  service.add_method(
+      tests::TestBidirStreamingService::kTestBidirStreamingService_TestMethod_name,
+      [&](rpc::Stream_future<::tests::TestRequest> reqs,
+          const rpc::server::Call_context&) {
+        auto rep = std::make_shared<rpc::Stream_promise<::tests::TestReply>>();
+        auto result = rep->get_future();
+
+        reqs.for_each([](::tests::TestRequest) {})
+            .finally([&, rep](rpc::expected<void> status) {
+              requests_failed.set_value(!status.has_value());
+              rep->complete();
+            });
+        return result;
+      });
+
+  Fixture fixture(std::move(service));
+  tests::TestBidirStreamingService::Stub stub(&fixture.channel);
+
+  auto [req_stream, rep_stream] = stub.TestMethod();
+  auto done = rep_stream.for_each([](::tests::TestReply) {});
+  req_stream.push(::tests::TestRequest{});
+  req_stream.set_exception(std::make_exception_ptr(std::runtime_error("nope")));
+
+  EXPECT_THROW(done.get(), rpc::Rpc_error);
+  auto failed = requests_failed.get_future();
+  ASSERT_EQ(failed.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_TRUE(failed.get());
+}
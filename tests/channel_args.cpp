@@ -0,0 +1,91 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace rpc = easy_grpc;
+
+TEST(channel_args, builder) {
+  rpc::Channel_args args;
+  EXPECT_TRUE(args.empty());
+
+  args.max_receive_message_size(1024)
+      .keepalive(std::chrono::seconds(10), std::chrono::seconds(2))
+      .set("custom.string", "value");
+
+  ASSERT_NE(args.find(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH), nullptr);
+  EXPECT_EQ(std::get<int>(*args.find(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH)), 1024);
+  EXPECT_EQ(std::get<int>(*args.find(GRPC_ARG_KEEPALIVE_TIME_MS)), 10000);
+  EXPECT_EQ(std::get<int>(*args.find(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS)), 0);
+  EXPECT_EQ(args.find(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH), nullptr);
+
+  // The last value wins, including when merging.
+  rpc::Channel_args more;
+  more.max_receive_message_size(-1).bdp_probe(false);
+  args.max_receive_message_size(2048).merge(more);
+  EXPECT_EQ(std::get<int>(*args.find(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH)), -1);
+
+  auto grpc_args = args.to_grpc();
+  EXPECT_EQ(grpc_args.size(), 6U);
+  for (const auto& arg : grpc_args) {
+    if (std::strcmp(arg.key, "custom.string") == 0) {
+      ASSERT_EQ(arg.type, GRPC_ARG_STRING);
+      EXPECT_STREQ(arg.value.string, "value");
+    } else {
+      EXPECT_EQ(arg.type, GRPC_ARG_INTEGER);
+    }
+  }
+
+  EXPECT_THROW(args.keepalive(std::chrono::milliseconds(-1), {}),
+               std::invalid_argument);
+}
+
+TEST(channel_args, message_size_limits) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("test.Sized");
+  service.add_method("/test.Sized/Echo", [](std::string req) { return req; });
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_channel_args(rpc::Channel_args().max_receive_message_size(8 << 20))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  auto addr = std::string("127.0.0.1:") + std::to_string(server_port);
+  std::string large(6 << 20, 'x');
+
+  // Over grpc's default 4MB on the way back.
+  rpc::client::Unsecure_channel default_channel(addr, &client_queue);
+  rpc::client::Method_stub<std::string, std::string> default_echo(
+      "/test.Sized/Echo", &default_channel);
+  try {
+    default_echo(large).get();
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_RESOURCE_EXHAUSTED);
+  }
+
+  rpc::client::Unsecure_channel raised_channel(
+      addr, &client_queue, rpc::Channel_args().max_receive_message_size(-1));
+  rpc::client::Method_stub<std::string, std::string> raised_echo(
+      "/test.Sized/Echo", &raised_channel);
+  EXPECT_EQ(raised_echo(large).get(), large);
+
+  // Over the server's limit on the way in.
+  std::string too_large(10 << 20, 'x');
+  try {
+    raised_echo(too_large).get();
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_RESOURCE_EXHAUSTED);
+  }
+}
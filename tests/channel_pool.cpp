@@ -0,0 +1,128 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+class Test_sync_impl {
+ public:
+  ::tests::TestReply TestMethod(::tests::TestRequest req) {
+    ::tests::TestReply result;
+    result.set_name(req.name() + "_replied");
+    return result;
+  }
+};
+
+void wait_until(const std::function<bool()>& condition) {
+  while (!condition()) {
+    std::this_thread::yield();
+  }
+}
+}  // namespace
+
+TEST(channel_pool, generated_stub) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Test_sync_impl impl;
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(::tests::TestService::get_config(impl))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Channel_pool pool(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue,
+      3);
+  ::tests::TestService::Stub stub(&pool);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  std::vector<rpc::Future<::tests::TestReply>> replies;
+  for (int i = 0; i < 9; ++i) {
+    replies.push_back(stub.TestMethod(req));
+  }
+  for (auto& rep : replies) {
+    EXPECT_EQ(rep.get().name(), "dude_replied");
+  }
+
+  EXPECT_THROW(rpc::client::Channel_pool("127.0.0.1:1", &client_queue, 0),
+               std::invalid_argument);
+}
+
+TEST(channel_pool, least_outstanding) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  std::mutex mtx;
+  std::vector<rpc::Promise<std::string>> held;
+
+  rpc::server::Service_config service("test.Held");
+  service.add_method("/test.Held/Hold", [&](std::string) {
+    std::lock_guard l(mtx);
+    held.emplace_back();
+    return held.back().get_future();
+  });
+  rpc::server::Method_options options;
+  options.listener_depth = 8;
+  service.set_method_options(options);
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Channel_pool pool(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue,
+      4, rpc::client::Channel_pool::Policy::least_outstanding);
+  rpc::client::Method_stub<std::string, std::string> hold("/test.Held/Hold",
+                                                          &pool);
+
+  // Each call goes to a connection that has none in flight yet.
+  std::vector<rpc::Future<std::string>> replies;
+  for (int i = 0; i < 4; ++i) {
+    replies.push_back(hold("x"));
+  }
+  for (std::size_t i = 0; i < pool.size(); ++i) {
+    EXPECT_EQ(pool.in_flight(i), 1U);
+  }
+
+  wait_until([&] {
+    std::lock_guard l(mtx);
+    return held.size() == 4;
+  });
+  {
+    std::lock_guard l(mtx);
+    for (auto& p : held) {
+      p.set_value("done");
+    }
+  }
+  for (auto& rep : replies) {
+    EXPECT_EQ(rep.get(), "done");
+  }
+
+  wait_until([&] {
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      if (pool.in_flight(i) != 0) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
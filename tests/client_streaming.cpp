@@ -3,6 +3,13 @@
 #include "generated/test.egrpc.pb.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace rpc = easy_grpc;
 
 namespace {
@@ -21,6 +28,29 @@ class Test_async_impl {
       });
   }
 };
+
+// Stops reading requests until the gate opens.
+class Test_gated_impl {
+ public:
+  using service_type = tests::TestClientStreamingService;
+
+  explicit Test_gated_impl(std::shared_future<void> gate) : gate_(std::move(gate)) {}
+
+  ::easy_grpc::Future<::tests::TestReply> TestMethod(::easy_grpc::Stream_future<::tests::TestRequest> reader) {
+    std::shared_ptr<int> count = std::make_shared<int>(0);
+    return reader.for_each([count, gate = gate_](::tests::TestRequest) mutable {
+        gate.wait();
+        *count += 1;
+      }).then([count]() {
+        ::tests::TestReply reply;
+        reply.set_count(*count);
+        return reply;
+      });
+  }
+
+ private:
+  std::shared_future<void> gate_;
+};
 }
 
 TEST(client_streaming, simple_call) {
@@ -56,3 +86,167 @@ TEST(client_streaming, simple_call) {
   req_stream.complete();
   EXPECT_EQ(rep_fut.get().count(), 6);
 }
+
+TEST(client_streaming, bounded_upload) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  std::promise<void> gate;
+  Test_gated_impl srv(gate.get_future().share());
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestClientStreamingService::get_config(srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestClientStreamingService::Stub stub(&channel);
+
+  rpc::client::Call_options options;
+  options.stream_capacity = 4;
+  auto [req_stream, rep_fut] = stub.TestMethod(rpc::client::with_writer, options);
+  EXPECT_EQ(req_stream.capacity(), 4U);
+
+  constexpr int total = 2000;
+  std::atomic<int> produced = 0;
+  std::thread producer([&, writer = req_stream]() mutable {
+    ::tests::TestRequest req;
+    req.set_name(std::string(16 * 1024, 'u'));
+    for (int i = 0; i < total; ++i) {
+      writer.ready().get();
+      writer.push(req);
+      ++produced;
+    }
+    writer.complete();
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  auto produced_while_stalled = produced.load();
+  EXPECT_GT(produced_while_stalled, 0);
+  EXPECT_LT(produced_while_stalled, total);
+
+  gate.set_value();
+  EXPECT_EQ(rep_fut.get().count(), total);
+  producer.join();
+}
+
+TEST(client_streaming, failed_upload) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_async_impl async_srv;
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestClientStreamingService::get_config(async_srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestClientStreamingService::Stub stub(&channel);
+
+  auto [req_stream, rep_fut] = stub.TestMethod(rpc::client::with_writer);
+
+  req_stream.push({});
+  req_stream.set_exception(std::make_exception_ptr(std::runtime_error("woops")));
+  EXPECT_FALSE(req_stream.push({}));
+
+  EXPECT_THROW(rep_fut.get(), rpc::Rpc_error);
+}
+
+TEST(client_streaming, concurrent_producers) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_async_impl async_srv;
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestClientStreamingService::get_config(async_srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestClientStreamingService::Stub stub(&channel);
+
+  rpc::client::Call_options options;
+  options.stream_capacity = 8;
+  auto [req_stream, rep_fut] = stub.TestMethod(rpc::client::with_writer, options);
+
+  constexpr int producer_count = 4;
+  constexpr int per_producer = 500;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; ++p) {
+    producers.emplace_back([writer = req_stream]() mutable {
+      for (int i = 0; i < per_producer; ++i) {
+        writer.ready().get();
+        writer.push({});
+      }
+    });
+  }
+
+  for (auto& p : producers) {
+    p.join();
+  }
+  req_stream.complete();
+
+  EXPECT_EQ(rep_fut.get().count(), producer_count * per_producer);
+}
+
+// Dropping the requests without ending them cancels the call instead of
+// leaving it open.
+TEST(client_streaming, dropped_requests) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_async_impl async_srv;
+
+  int server_port = 0;
+  rpc::server::Server server = std::move(
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestClientStreamingService::get_config(async_srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestClientStreamingService::Stub stub(&channel);
+
+  auto promise_reply = [&] {
+    auto [req_stream, rep_fut] = stub.TestMethod();
+    req_stream.push(::tests::TestRequest{});
+    return std::move(rep_fut);
+  }();
+  EXPECT_THROW(promise_reply.get(), rpc::Rpc_error);
+
+  auto writer_reply = [&] {
+    auto [req_stream, rep_fut] = stub.TestMethod(rpc::client::with_writer);
+    req_stream.push({});
+    return std::move(rep_fut);
+  }();
+  EXPECT_THROW(writer_reply.get(), rpc::Rpc_error);
+}
@@ -0,0 +1,126 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+namespace rpc = easy_grpc;
+
+namespace {
+class Test_sync_impl {
+ public:
+  using service_type = tests::TestService;
+
+  ::tests::TestReply TestMethod(::tests::TestRequest req) {
+    ::tests::TestReply result;
+    result.set_name(req.name() + "_replied");
+
+    return result;
+  }
+};
+
+class Counting_stream_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  ::rpc::Stream_future<::tests::TestReply> TestMethod(::tests::TestRequest) {
+    ::rpc::Stream_promise<::tests::TestReply> rep;
+    auto result = rep.get_future();
+
+    for (int i = 0; i < 500; ++i) {
+      ::tests::TestReply val;
+      val.set_count(i);
+      rep.push(val);
+    }
+    rep.complete();
+    return result;
+  }
+};
+}  // namespace
+
+TEST(completion_queue, thread_count) {
+  rpc::Environment env;
+
+  rpc::Completion_queue default_queue;
+  rpc::Completion_queue wide_queue(4);
+
+  EXPECT_EQ(default_queue.thread_count(), 1);
+  EXPECT_EQ(wide_queue.thread_count(), 4);
+
+  EXPECT_THROW(rpc::Completion_queue(0), std::invalid_argument);
+}
+
+TEST(completion_queue, pinned_threads) {
+  rpc::Environment env;
+
+  rpc::Completion_queue queue(2, {0});
+  EXPECT_EQ(queue.thread_count(), 2);
+
+  EXPECT_THROW(rpc::Completion_queue(1, {-1}), std::invalid_argument);
+  EXPECT_THROW(rpc::Completion_queue(1, {0, 1 << 20}), std::invalid_argument);
+}
+
+TEST(completion_queue, multi_threaded_unary) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue(4);
+  rpc::Completion_queue client_queue(4);
+
+  Test_sync_impl sync_srv;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(sync_srv)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  std::vector<rpc::Future<::tests::TestReply>> results;
+  for (int i = 0; i < 2000; ++i) {
+    results.emplace_back(stub.TestMethod(req));
+  }
+
+  for (auto& f : results) {
+    EXPECT_EQ(f.get().name(), "dude_replied");
+  }
+}
+
+TEST(completion_queue, multi_threaded_stream_ordering) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue(4);
+  rpc::Completion_queue client_queue(4);
+
+  Counting_stream_impl impl;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(tests::TestServerStreamingService::get_config(impl))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  auto expected = std::make_shared<int>(0);
+  auto in_order = std::make_shared<bool>(true);
+  auto done = stub.TestMethod(::tests::TestRequest())
+                  .for_each([expected, in_order](::tests::TestReply rep) {
+                    if (rep.count() != *expected) {
+                      *in_order = false;
+                    }
+                    ++*expected;
+                  })
+                  .then([expected]() { return *expected; });
+
+  EXPECT_EQ(done.get(), 500);
+  EXPECT_TRUE(*in_order);
+}
@@ -0,0 +1,95 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace rpc = easy_grpc;
+
+namespace {
+std::string compressible_payload() {
+  std::string result;
+  while (result.size() < 100000) {
+    result += "the quick brown fox jumps over the lazy dog. ";
+  }
+  return result;
+}
+}  // namespace
+
+TEST(compression, per_call) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("test.Compressed");
+  service.add_method("/test.Compressed/Echo",
+                     [](std::string req) { return req; });
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> echo(
+      "/test.Compressed/Echo", &channel);
+
+  auto payload = compressible_payload();
+  for (auto algorithm :
+       {GRPC_COMPRESS_NONE, GRPC_COMPRESS_DEFLATE, GRPC_COMPRESS_GZIP}) {
+    rpc::client::Call_options options;
+    options.compression = algorithm;
+    EXPECT_EQ(echo(payload, options).get(), payload);
+  }
+}
+
+TEST(compression, defaults) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("test.Compressed");
+  service.add_method("/test.Compressed/Echo",
+                     [](std::string req) { return req; });
+
+  // Opts out of the server's default.
+  rpc::server::Method_options raw;
+  raw.compression_level = GRPC_COMPRESS_LEVEL_NONE;
+  service.add_method("/test.Compressed/Raw",
+                     [](std::string req) { return req; }, {}, raw);
+
+  rpc::Compression_options server_compression;
+  server_compression.level = GRPC_COMPRESS_LEVEL_HIGH;
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .set_default_compression(server_compression)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::Compression_options channel_compression;
+  channel_compression.algorithm = GRPC_COMPRESS_GZIP;
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue,
+      channel_compression);
+  rpc::client::Method_stub<std::string, std::string> echo(
+      "/test.Compressed/Echo", &channel);
+  rpc::client::Method_stub<std::string, std::string> raw_echo(
+      "/test.Compressed/Raw", &channel);
+
+  auto payload = compressible_payload();
+  EXPECT_EQ(echo(payload).get(), payload);
+  EXPECT_EQ(raw_echo(payload).get(), payload);
+
+  rpc::client::Call_options uncompressed;
+  uncompressed.compression = GRPC_COMPRESS_NONE;
+  EXPECT_EQ(echo(payload, uncompressed).get(), payload);
+}
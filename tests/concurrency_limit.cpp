@@ -0,0 +1,223 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// Replies to calls only when told to.
+class Held_calls {
+ public:
+  rpc::Future<std::string> hold() {
+    std::lock_guard l(mtx_);
+    pending_.emplace_back();
+    return pending_.back().get_future();
+  }
+
+  std::size_t count() {
+    std::lock_guard l(mtx_);
+    return pending_.size();
+  }
+
+  void wait_for(std::size_t n) {
+    while (count() < n) {
+      std::this_thread::yield();
+    }
+  }
+
+  void release_all() {
+    std::vector<rpc::Promise<std::string>> pending;
+    {
+      std::lock_guard l(mtx_);
+      pending = std::move(pending_);
+      pending_.clear();
+    }
+    for (auto& p : pending) {
+      p.set_value("done");
+    }
+  }
+
+ private:
+  std::mutex mtx_;
+  std::vector<rpc::Promise<std::string>> pending_;
+};
+
+grpc_status_code status_of(rpc::Future<std::string> fut) {
+  try {
+    fut.get();
+  } catch (rpc::Rpc_error& e) {
+    return e.code();
+  }
+  return GRPC_STATUS_OK;
+}
+}  // namespace
+
+TEST(concurrency_limit, limiter) {
+  rpc::server::Concurrency_limit limit(2, 1);
+
+  EXPECT_TRUE(limit.try_acquire());
+  EXPECT_TRUE(limit.try_acquire());
+  EXPECT_FALSE(limit.try_acquire());
+
+  int started = 0;
+  EXPECT_TRUE(limit.enqueue([&] { ++started; }));
+  EXPECT_FALSE(limit.enqueue([&] { ++started; }));
+  EXPECT_EQ(limit.queued(), 1U);
+  EXPECT_EQ(limit.rejected(), 1U);
+  EXPECT_EQ(started, 0);
+
+  // The queued call takes over the freed slot.
+  limit.release({});
+  EXPECT_EQ(started, 1);
+  EXPECT_EQ(limit.in_flight(), 2U);
+
+  limit.release({});
+  limit.release({});
+  EXPECT_EQ(limit.in_flight(), 0U);
+
+  EXPECT_THROW(rpc::server::Concurrency_limit(0), std::invalid_argument);
+}
+
+TEST(concurrency_limit, adaptive) {
+  using namespace std::chrono_literals;
+
+  rpc::server::Adaptive_limit_options options;
+  options.initial_limit = 10;
+  options.latency_threshold = 10ms;
+  options.backoff_ratio = 0.5;
+
+  rpc::server::Adaptive_concurrency_limit limit(options);
+  EXPECT_EQ(limit.limit(), 10U);
+
+  // Fast calls, with the limit in use.
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(limit.try_acquire());
+  }
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(limit.try_acquire());
+    limit.release(1ms);
+  }
+  EXPECT_EQ(limit.limit(), 11U);
+
+  // Slow calls that were admitted before the first cut only cause one.
+  limit.release(1s);
+  limit.release(1s);
+  EXPECT_EQ(limit.limit(), 5U);
+  EXPECT_EQ(limit.backoffs(), 1U);
+
+  // This one got its slot after the cut.
+  std::this_thread::sleep_for(20ms);
+  limit.release(15ms);
+  EXPECT_EQ(limit.limit(), 2U);
+  EXPECT_EQ(limit.backoffs(), 2U);
+
+  EXPECT_THROW(rpc::server::Adaptive_concurrency_limit(
+                   rpc::server::Adaptive_limit_options{0, 1, 1}),
+               std::invalid_argument);
+}
+
+TEST(concurrency_limit, queue_then_shed) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Held_calls held;
+
+  rpc::server::Method_options options;
+  options.concurrency_limit =
+      std::make_shared<rpc::server::Concurrency_limit>(1, 1);
+
+  rpc::server::Service_config service("test.Limited");
+  service.add_method("/test.Limited/Hold",
+                     [&](rpc::Byte_slice) { return held.hold(); }, {},
+                     options);
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  rpc::client::Method_stub<rpc::Byte_slice, std::string> hold(
+      "/test.Limited/Hold", &channel);
+
+  auto first = hold(rpc::Byte_slice(std::string("a")));
+  held.wait_for(1);
+
+  auto second = hold(rpc::Byte_slice(std::string("b")));
+  while (options.concurrency_limit->queued() == 0) {
+    std::this_thread::yield();
+  }
+
+  auto third = hold(rpc::Byte_slice(std::string("c")));
+  EXPECT_EQ(status_of(std::move(third)), GRPC_STATUS_RESOURCE_EXHAUSTED);
+
+  // The queued call only reaches the handler once the first one is done.
+  EXPECT_EQ(held.count(), 1U);
+  held.release_all();
+  EXPECT_EQ(first.get(), "done");
+
+  held.wait_for(1);
+  held.release_all();
+  EXPECT_EQ(second.get(), "done");
+
+  auto stats = server.method_stats("/test.Limited/Hold");
+  EXPECT_EQ(stats->calls_shed.load(), 1U);
+}
+
+TEST(concurrency_limit, shared_by_service) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  Held_calls held;
+
+  rpc::server::Service_config service("test.Limited");
+  service.add_method("/test.Limited/A",
+                     [&](rpc::Byte_slice) { return held.hold(); });
+  service.add_method("/test.Limited/B",
+                     [&](rpc::Byte_slice) { return held.hold(); });
+
+  int server_port = 0;
+  rpc::server::Server server(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(service))
+          .add_feature(rpc::server::Concurrency_limit_feature(
+              1, 0, rpc::server::Concurrency_limit_feature::Scope::service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  rpc::client::Method_stub<rpc::Byte_slice, std::string> a("/test.Limited/A",
+                                                           &channel);
+  rpc::client::Method_stub<rpc::Byte_slice, std::string> b("/test.Limited/B",
+                                                           &channel);
+
+  auto first = a(rpc::Byte_slice(std::string("a")));
+  held.wait_for(1);
+
+  EXPECT_EQ(status_of(b(rpc::Byte_slice(std::string("b")))),
+            GRPC_STATUS_RESOURCE_EXHAUSTED);
+
+  held.release_all();
+  EXPECT_EQ(first.get(), "done");
+
+  // The slot is free again.
+  auto second = b(rpc::Byte_slice(std::string("b")));
+  held.wait_for(1);
+  held.release_all();
+  EXPECT_EQ(second.get(), "done");
+}
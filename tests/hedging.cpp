@@ -0,0 +1,242 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+using namespace std::chrono_literals;
+
+namespace {
+// Two servers on loopback. The first one answers right away, the second one
+// sits on its calls until release().
+class Slow_and_fast {
+ public:
+  Slow_and_fast() {
+    for (int i = 0; i < 2; ++i) {
+      rpc::server::Service_config service("test.Replica");
+      service.add_method("/test.Replica/Whoami", [this, i](std::string) {
+        rpc::Promise<std::string> rep;
+        auto result = rep.get_future();
+        if (i == 0) {
+          rep.set_value("fast");
+        } else {
+          std::lock_guard l(mtx_);
+          held_.push_back(std::move(rep));
+        }
+        return result;
+      });
+
+      int port = 0;
+      servers_.push_back(std::make_unique<rpc::server::Server>(
+          rpc::server::Config()
+              .add_default_listening_queues({&queue_, &queue_ + 1})
+              .add_service(std::move(service))
+              .add_listening_port("127.0.0.1:0", {}, &port)));
+      addresses_.push_back("127.0.0.1:" + std::to_string(port));
+    }
+  }
+
+  const std::vector<std::string>& addresses() const { return addresses_; }
+
+  std::size_t held() {
+    std::lock_guard l(mtx_);
+    return held_.size();
+  }
+
+  void release() {
+    std::lock_guard l(mtx_);
+    for (auto& rep : held_) {
+      rep.set_value("slow");
+    }
+    held_.clear();
+  }
+
+ private:
+  rpc::Completion_queue queue_;
+  std::vector<std::string> addresses_;
+
+  std::mutex mtx_;
+  std::vector<rpc::Promise<std::string>> held_;
+
+  std::vector<std::unique_ptr<rpc::server::Server>> servers_;
+};
+
+void wait_until(const std::function<bool()>& condition) {
+  while (!condition()) {
+    std::this_thread::yield();
+  }
+}
+
+// Sends a call to each replica, so that connecting doesn't count against the
+// hedge delay later on. The round-robin ends up back on the fast replica.
+void connect(Slow_and_fast& replicas,
+             rpc::client::Method_stub<std::string, std::string>& whoami) {
+  auto fast = whoami("");
+  auto slow = whoami("");
+  EXPECT_EQ(fast.get(), "fast");
+  wait_until([&] { return replicas.held() == 1; });
+  replicas.release();
+  EXPECT_EQ(slow.get(), "slow");
+}
+}  // namespace
+
+TEST(hedging, budget) {
+  rpc::client::Hedging_policy policy(10ms, 0.5, 2.0);
+
+  // Starts with a full bucket.
+  EXPECT_TRUE(policy.try_hedge());
+  EXPECT_TRUE(policy.try_hedge());
+  EXPECT_FALSE(policy.try_hedge());
+
+  // Two calls earn one hedge.
+  policy.on_call();
+  EXPECT_FALSE(policy.try_hedge());
+  policy.on_call();
+  EXPECT_TRUE(policy.try_hedge());
+
+  EXPECT_EQ(policy.stats().hedges_issued, 3U);
+  EXPECT_EQ(policy.stats().hedges_throttled, 2U);
+
+  EXPECT_THROW(rpc::client::Hedging_policy(10ms, 0.1, 0.0),
+               std::invalid_argument);
+}
+
+TEST(hedging, slow_replica) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Slow_and_fast replicas;
+
+  rpc::client::Balanced_channel channel(replicas.addresses(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", &channel);
+  connect(replicas, whoami);
+
+  auto policy = std::make_shared<rpc::client::Hedging_policy>(20ms);
+  whoami.set_hedging(policy);
+
+  // Replies that come in before the delay are not hedged.
+  EXPECT_EQ(whoami("").get(), "fast");
+  EXPECT_EQ(policy->stats().hedges_issued, 0U);
+
+  // On the slow replica, so the hedge goes to the fast one.
+  EXPECT_EQ(whoami("").get(), "fast");
+  EXPECT_EQ(policy->stats().hedges_issued, 1U);
+  EXPECT_EQ(policy->stats().hedges_won, 1U);
+
+  // The slow copy got cancelled.
+  wait_until([&] { return channel.in_flight(1) == 0; });
+
+  // Hedges take their turn in the round-robin too, so this starts on the slow
+  // replica again.
+  EXPECT_EQ(whoami("").get(), "fast");
+  EXPECT_EQ(policy->stats().hedges_issued, 2U);
+  EXPECT_EQ(policy->stats().hedges_won, 2U);
+
+  replicas.release();
+}
+
+TEST(hedging, over_budget) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Slow_and_fast replicas;
+
+  rpc::client::Balanced_channel channel(replicas.addresses(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", &channel);
+  connect(replicas, whoami);
+
+  rpc::client::Call_options options;
+  options.hedging =
+      std::make_shared<rpc::client::Hedging_policy>(10ms, 0.0, 1.0);
+
+  // On the fast replica, then hedged away from the slow one.
+  EXPECT_EQ(whoami("", options).get(), "fast");
+  EXPECT_EQ(whoami("", options).get(), "fast");
+
+  // Back on the slow replica, with no budget left to hedge.
+  auto rep = whoami("", options);
+  wait_until([&] { return options.hedging->stats().hedges_throttled == 1; });
+  wait_until([&] { return replicas.held() == 2; });
+  replicas.release();
+  EXPECT_EQ(rep.get(), "slow");
+
+  EXPECT_EQ(options.hedging->stats().hedges_issued, 1U);
+}
+
+TEST(hedging, keyed_calls_avoid_the_slow_replica) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Slow_and_fast replicas;
+
+  rpc::client::Balanced_channel channel(
+      replicas.addresses(), &client_queue,
+      std::make_unique<rpc::client::Consistent_hash_policy>());
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", &channel);
+
+  auto policy = std::make_shared<rpc::client::Hedging_policy>(10ms, 1.0);
+  whoami.set_hedging(policy);
+
+  // The keys of the slow replica get hedged, and their hedge must not follow
+  // the key back there.
+  for (int i = 0; i < 20; ++i) {
+    rpc::client::Call_options options;
+    options.balancing_key = "user-" + std::to_string(i);
+    options.deadline = gpr_time_add(gpr_now(GPR_CLOCK_REALTIME),
+                                    gpr_time_from_seconds(5, GPR_TIMESPAN));
+    EXPECT_EQ(whoami("", options).get(), "fast");
+  }
+  EXPECT_GT(policy->stats().hedges_won, 0U);
+
+  replicas.release();
+}
+
+TEST(hedging, settled_call_releases_its_queue) {
+  rpc::Environment env;
+  Slow_and_fast replicas;
+  auto client_queue = std::make_unique<rpc::Completion_queue>();
+
+  {
+    rpc::client::Balanced_channel channel({replicas.addresses()[0]},
+                                          client_queue.get());
+    rpc::client::Method_stub<std::string, std::string> whoami(
+        "/test.Replica/Whoami", &channel);
+    whoami.set_hedging(std::make_shared<rpc::client::Hedging_policy>(1h));
+
+    EXPECT_EQ(whoami("").get(), "fast");
+  }
+
+  // Would wait for the hedge delay if the alarm was still pending.
+  auto start = std::chrono::steady_clock::now();
+  client_queue.reset();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(hedging, channel_destroyed_before_the_hedge) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Slow_and_fast replicas;
+
+  auto channel = std::make_unique<rpc::client::Balanced_channel>(
+      std::vector<std::string>{replicas.addresses()[1]}, &client_queue);
+  rpc::client::Method_stub<std::string, std::string> whoami(
+      "/test.Replica/Whoami", channel.get());
+  whoami.set_hedging(std::make_shared<rpc::client::Hedging_policy>(100ms));
+
+  auto rep = whoami("");
+  wait_until([&] { return replicas.held() == 1; });
+  channel.reset();
+
+  // The hedge has nowhere to go, but the first copy carries on.
+  std::this_thread::sleep_for(200ms);
+  replicas.release();
+  EXPECT_EQ(rep.get(), "slow");
+}
@@ -0,0 +1,59 @@
+#include "easy_grpc/mpsc_queue.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+TEST(mpsc_queue, fifo) {
+  rpc::detail::Mpsc_queue<std::unique_ptr<int>> queue;
+  EXPECT_TRUE(queue.empty());
+
+  queue.push(std::make_unique<int>(1));
+  queue.push(std::make_unique<int>(2));
+  EXPECT_FALSE(queue.empty());
+
+  EXPECT_EQ(**queue.pop(), 1);
+  EXPECT_EQ(**queue.pop(), 2);
+  EXPECT_FALSE(queue.pop());
+
+  // Whatever is left is destroyed with the queue.
+  queue.push(std::make_unique<int>(3));
+}
+
+TEST(mpsc_queue, concurrent_producers) {
+  constexpr int producer_count = 8;
+  constexpr int per_producer = 10000;
+
+  rpc::detail::Mpsc_queue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < per_producer; ++i) {
+        queue.push({p, i});
+      }
+    });
+  }
+
+  // Each producer's messages come out in the order they were pushed.
+  std::vector<int> next(producer_count, 0);
+  int received = 0;
+  while (received < producer_count * per_producer) {
+    if (auto val = queue.pop()) {
+      EXPECT_EQ(val->second, next[val->first]);
+      ++next[val->first];
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto& p : producers) {
+    p.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,144 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace rpc = easy_grpc;
+
+using namespace std::chrono_literals;
+
+namespace {
+// A server whose method fails with code until it has been called
+// fail_count times.
+class Flaky {
+ public:
+  Flaky(int fail_count, grpc_status_code code = GRPC_STATUS_UNAVAILABLE) {
+    rpc::server::Service_config service("test.Flaky");
+    service.add_method("/test.Flaky/Call", [this, fail_count, code](std::string) {
+      if (++calls_ <= fail_count) {
+        throw rpc::Rpc_error(code, "flaky");
+      }
+      rpc::Promise<std::string> rep;
+      rep.set_value("ok");
+      return rep.get_future();
+    });
+
+    server_ = std::make_unique<rpc::server::Server>(
+        rpc::server::Config()
+            .add_default_listening_queues({&queue_, &queue_ + 1})
+            .add_service(std::move(service))
+            .add_listening_port("127.0.0.1:0", {}, &port_));
+  }
+
+  std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+  int calls() const { return calls_; }
+
+ private:
+  rpc::Completion_queue queue_;
+  std::atomic<int> calls_ = 0;
+  int port_ = 0;
+  std::unique_ptr<rpc::server::Server> server_;
+};
+
+std::shared_ptr<rpc::client::Retry_policy> quick_retries(
+    std::size_t max_attempts) {
+  auto policy = std::make_shared<rpc::client::Retry_policy>();
+  policy->max_attempts = max_attempts;
+  policy->initial_backoff = 1ms;
+  policy->max_backoff = 5ms;
+  return policy;
+}
+}  // namespace
+
+TEST(retry, backoff) {
+  rpc::client::Retry_policy policy;
+  policy.initial_backoff = 100ms;
+  policy.max_backoff = 300ms;
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_LE(policy.backoff(1), 100ms);
+    EXPECT_LE(policy.backoff(2), 200ms);
+    EXPECT_LE(policy.backoff(5), 300ms);
+  }
+
+  EXPECT_TRUE(policy.is_retryable(GRPC_STATUS_UNAVAILABLE));
+  EXPECT_FALSE(policy.is_retryable(GRPC_STATUS_INVALID_ARGUMENT));
+}
+
+TEST(retry, recovers) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Flaky server(2);
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> call("/test.Flaky/Call",
+                                                          &channel);
+  call.set_retry_policy(quick_retries(3));
+
+  EXPECT_EQ(call("").get(), "ok");
+  EXPECT_EQ(server.calls(), 3);
+}
+
+TEST(retry, gives_up) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Flaky server(5);
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> call("/test.Flaky/Call",
+                                                          &channel);
+
+  rpc::client::Call_options options;
+  options.retry = quick_retries(3);
+
+  try {
+    call("", options).get();
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_UNAVAILABLE);
+  }
+  EXPECT_EQ(server.calls(), 3);
+}
+
+TEST(retry, not_retryable) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Flaky server(1, GRPC_STATUS_INVALID_ARGUMENT);
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> call("/test.Flaky/Call",
+                                                          &channel);
+  call.set_retry_policy(quick_retries(3));
+
+  EXPECT_THROW(call("").get(), rpc::Rpc_error);
+  EXPECT_EQ(server.calls(), 1);
+}
+
+TEST(retry, deadline) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Flaky server(5);
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> call("/test.Flaky/Call",
+                                                          &channel);
+
+  // Any backoff is all but certain to end past the deadline.
+  auto policy = std::make_shared<rpc::client::Retry_policy>();
+  policy->initial_backoff = std::chrono::hours(1);
+  policy->max_backoff = std::chrono::hours(1);
+
+  rpc::client::Call_options options;
+  options.retry = policy;
+  options.deadline = gpr_time_add(gpr_now(GPR_CLOCK_REALTIME),
+                                  gpr_time_from_seconds(5, GPR_TIMESPAN));
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_THROW(call("", options).get(), rpc::Rpc_error);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+  EXPECT_EQ(server.calls(), 1);
+}
@@ -0,0 +1,147 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// Builds a byte buffer holding data split in slices of at most slice_size.
+grpc_byte_buffer* make_chunked_buffer(const std::string& data,
+                                      std::size_t slice_size) {
+  std::vector<grpc_slice> slices;
+  for (std::size_t i = 0; i < data.size(); i += slice_size) {
+    auto len = std::min(slice_size, data.size() - i);
+    slices.push_back(grpc_slice_from_copied_buffer(data.data() + i, len));
+  }
+
+  auto result = grpc_raw_byte_buffer_create(slices.data(), slices.size());
+  for (auto& s : slices) {
+    grpc_slice_unref(s);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(serialize, multi_slice_deserialize) {
+  ::tests::TestReply msg;
+  msg.set_name(std::string(100000, 'a') + "b");
+  msg.set_count(12);
+
+  std::string raw;
+  ASSERT_TRUE(msg.SerializeToString(&raw));
+
+  for (std::size_t slice_size : {1, 7, 4096, 1000000}) {
+    auto buffer = make_chunked_buffer(raw, slice_size);
+    auto result = rpc::deserialize<::tests::TestReply>(buffer);
+    grpc_byte_buffer_destroy(buffer);
+
+    EXPECT_EQ(result.name(), msg.name());
+    EXPECT_EQ(result.count(), 12);
+  }
+}
+
+TEST(serialize, input_stream_backup) {
+  // Large enough that grpc does not merge the slices back together.
+  auto buffer = make_chunked_buffer(std::string(40, 'a') + std::string(40, 'b'), 40);
+
+  rpc::Byte_buffer_input_stream stream(buffer);
+  const void* data;
+  int size;
+
+  ASSERT_TRUE(stream.Next(&data, &size));
+  EXPECT_EQ(std::string(static_cast<const char*>(data), size), std::string(40, 'a'));
+
+  stream.BackUp(10);
+  EXPECT_EQ(stream.ByteCount(), 30);
+
+  ASSERT_TRUE(stream.Next(&data, &size));
+  EXPECT_EQ(std::string(static_cast<const char*>(data), size), std::string(10, 'a'));
+
+  ASSERT_TRUE(stream.Skip(35));
+  EXPECT_EQ(stream.ByteCount(), 75);
+
+  ASSERT_TRUE(stream.Next(&data, &size));
+  EXPECT_EQ(std::string(static_cast<const char*>(data), size), std::string(5, 'b'));
+  EXPECT_FALSE(stream.Next(&data, &size));
+
+  grpc_byte_buffer_destroy(buffer);
+}
+
+TEST(serialize, large_message_slice_chain) {
+  ::tests::TestReply msg;
+  msg.set_name(std::string(1000000, 'z'));
+  msg.set_count(3);
+
+  auto buffer = rpc::serialize(msg);
+
+  // Spread over several pooled blocks rather than one big slice.
+  EXPECT_GT(buffer->data.raw.slice_buffer.count, 1U);
+  EXPECT_EQ(grpc_byte_buffer_length(buffer), msg.ByteSizeLong());
+
+  auto result = rpc::deserialize<::tests::TestReply>(buffer);
+  grpc_byte_buffer_destroy(buffer);
+
+  EXPECT_EQ(result.name(), msg.name());
+  EXPECT_EQ(result.count(), 3);
+}
+
+TEST(serialize, small_message_single_slice) {
+  ::tests::TestReply msg;
+  msg.set_name("dude");
+
+  auto buffer = rpc::serialize(msg);
+  EXPECT_EQ(buffer->data.raw.slice_buffer.count, 1U);
+  EXPECT_EQ(rpc::deserialize<::tests::TestReply>(buffer).name(), "dude");
+  grpc_byte_buffer_destroy(buffer);
+}
+
+TEST(serialize, serialized_shares_payload) {
+  ::tests::TestReply msg;
+  msg.set_name(std::string(1000, 'x'));
+  msg.set_count(7);
+
+  rpc::Serialized<::tests::TestReply> shared(msg);
+  EXPECT_EQ(shared.size(), msg.ByteSizeLong());
+
+  auto a = rpc::serialize(shared);
+  auto b = rpc::serialize(shared);
+
+  // Both point at the same encoded bytes.
+  EXPECT_EQ(GRPC_SLICE_START_PTR(a->data.raw.slice_buffer.slices[0]),
+            GRPC_SLICE_START_PTR(b->data.raw.slice_buffer.slices[0]));
+
+  auto result = rpc::deserialize<::tests::TestReply>(a);
+  EXPECT_EQ(result.name(), msg.name());
+  EXPECT_EQ(result.count(), 7);
+
+  grpc_byte_buffer_destroy(a);
+  grpc_byte_buffer_destroy(b);
+
+  // The shared payload outlives the buffers handed out.
+  EXPECT_EQ(shared.get().count(), 7);
+}
+
+TEST(serialize, corrupt_buffer_is_invalid_argument) {
+  ::tests::TestReply msg;
+  msg.set_name(std::string(100, 'a'));
+
+  std::string raw;
+  ASSERT_TRUE(msg.SerializeToString(&raw));
+
+  // A truncated message and bytes that aren't a message at all.
+  for (auto data : {raw.substr(0, raw.size() / 2), std::string(16, '\xff')}) {
+    auto buffer = make_chunked_buffer(data, 7);
+    try {
+      rpc::deserialize<::tests::TestReply>(buffer);
+      ADD_FAILURE() << "deserialize accepted a corrupt buffer";
+    } catch (rpc::Rpc_error& e) {
+      EXPECT_EQ(e.code(), GRPC_STATUS_INVALID_ARGUMENT);
+    }
+    grpc_byte_buffer_destroy(buffer);
+  }
+}
@@ -3,6 +3,13 @@
 #include "generated/test.egrpc.pb.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace rpc = easy_grpc;
 
 namespace {
@@ -18,6 +25,30 @@ class Test_sync_impl {
   }
 };
 
+// Holds the thread it's called from until the gate opens.
+class Blocking_streaming_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  explicit Blocking_streaming_impl(std::shared_future<void> gate)
+      : gate_(std::move(gate)) {}
+
+  ::rpc::Stream_future<::tests::TestReply> TestMethod(::tests::TestRequest) {
+    entered.set_value();
+    gate_.wait();
+
+    ::rpc::Stream_promise<::tests::TestReply> rep;
+    auto result = rep.get_future();
+    rep.complete();
+    return result;
+  }
+
+  std::promise<void> entered;
+
+ private:
+  std::shared_future<void> gate_;
+};
+
 class Failing_impl : public tests::TestService {
  public:
   ::rpc::Future<::tests::TestReply> TestMethod(
@@ -49,6 +80,34 @@ class Failure_returning_impl : public tests::TestService {
     return result;
   }
 };
+
+// Sits on its calls until release().
+class Holding_impl : public tests::TestService {
+ public:
+  ::rpc::Future<::tests::TestReply> TestMethod(
+      ::tests::TestRequest) override {
+    std::lock_guard l(mtx_);
+    held_.emplace_back();
+    return held_.back().get_future();
+  }
+
+  std::size_t held() {
+    std::lock_guard l(mtx_);
+    return held_.size();
+  }
+
+  void release() {
+    std::lock_guard l(mtx_);
+    for (auto& rep : held_) {
+      rep.set_value(::tests::TestReply());
+    }
+    held_.clear();
+  }
+
+ private:
+  std::mutex mtx_;
+  std::vector<rpc::Promise<::tests::TestReply>> held_;
+};
 }  // namespace
 
 TEST(server, bind_failure) {
@@ -195,3 +254,292 @@ TEST(server, move_server) {
   }
   EXPECT_THROW(stub->TestMethod(req).get(), rpc::Rpc_error);
 }
+
+TEST(server, listener_depth) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  std::mutex mtx;
+  std::vector<rpc::Promise<::tests::TestReply>> pending;
+
+  rpc::server::Method_options options;
+  options.listener_depth = 16;
+
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(
+      tests::TestService::kTestService_TestMethod_name,
+      [&](::tests::TestRequest) {
+        std::lock_guard<std::mutex> l(mtx);
+        pending.emplace_back();
+        return pending.back().get_future();
+      },
+      {}, options);
+
+  auto cfg = rpc::server::Config();
+
+  int server_port = 0;
+  cfg.add_default_listening_queues(
+         {server_queues.begin(), server_queues.end()})
+      .add_service(std::move(service))
+      .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::server::Server srv(std::move(cfg));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  constexpr std::size_t call_count = 100;
+  std::vector<rpc::Future<::tests::TestReply>> results;
+  for (std::size_t i = 0; i < call_count; ++i) {
+    results.push_back(stub.TestMethod(req));
+  }
+
+  // Every call must reach the handler while none of them has completed yet.
+  while (true) {
+    {
+      std::lock_guard<std::mutex> l(mtx);
+      if (pending.size() == call_count) {
+        break;
+      }
+    }
+    std::this_thread::yield();
+  }
+
+  for (auto& p : pending) {
+    ::tests::TestReply rep;
+    rep.set_name("dude_replied");
+    p.set_value(rep);
+  }
+
+  for (auto& r : results) {
+    EXPECT_EQ(r.get().name(), "dude_replied");
+  }
+}
+
+TEST(server, handler_recycling) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_sync_impl sync_srv;
+
+  auto cfg = rpc::server::Config();
+
+  int server_port = 0;
+  cfg.add_default_listening_queues(
+         {server_queues.begin(), server_queues.end()})
+      .add_service(sync_srv)
+      .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::server::Server srv(std::move(cfg));
+
+  EXPECT_EQ(srv.method_stats("/tests.TestService/Missing"), nullptr);
+  auto stats =
+      srv.method_stats(tests::TestService::kTestService_TestMethod_name);
+  ASSERT_NE(stats, nullptr);
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  constexpr std::uint64_t call_count = 500;
+  for (std::uint64_t i = 0; i < call_count; ++i) {
+    EXPECT_EQ(stub.TestMethod(req).get().name(), "dude_replied");
+  }
+
+  // One handler is pending per listener, and a few more can be in flight
+  // while the previous call is wrapping up.
+  EXPECT_LE(stats->handlers_allocated.load(), 4U);
+  EXPECT_GE(stats->handlers_allocated.load() + stats->handlers_reused.load(),
+            call_count);
+}
+
+TEST(server, idle_handlers_are_capped) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+  Holding_impl holding_srv;
+
+  int server_port = 0;
+  rpc::server::Server srv(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(holding_srv)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+  auto stats =
+      srv.method_stats(tests::TestService::kTestService_TestMethod_name);
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestService::Stub stub(&channel);
+
+  constexpr std::size_t burst = 8;
+  std::vector<rpc::Future<::tests::TestReply>> replies;
+  for (std::size_t i = 0; i < burst; ++i) {
+    replies.push_back(stub.TestMethod(::tests::TestRequest()));
+  }
+  while (holding_srv.held() != burst) {
+    std::this_thread::yield();
+  }
+  holding_srv.release();
+  for (auto& rep : replies) {
+    rep.get();
+  }
+
+  // With a listener depth of 1, the pool keeps a single idle handler.
+  while (stats->handlers_freed.load() < burst - 1) {
+    std::this_thread::yield();
+  }
+  EXPECT_GE(stats->handlers_allocated.load(), burst);
+}
+
+TEST(server, dedicated_method_queue) {
+  rpc::Environment env;
+
+  rpc::Completion_queue default_queue;
+  rpc::Completion_queue dedicated_queue;
+  rpc::Completion_queue client_queue;
+
+  std::promise<void> gate;
+  Blocking_streaming_impl blocking_srv(gate.get_future().share());
+  Test_sync_impl sync_srv;
+
+  tests::TestService::Method_queues queues;
+  queues.TestMethod = {&dedicated_queue, &dedicated_queue + 1};
+
+  int server_port = 0;
+  rpc::server::Server srv(
+      rpc::server::Config()
+          .add_default_listening_queues({&default_queue, &default_queue + 1})
+          .add_service(blocking_srv)
+          .add_service(tests::TestService::get_config(sync_srv, queues))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub streaming_stub(&channel);
+  tests::TestService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  // Park the only thread of the default queue.
+  auto entered = blocking_srv.entered.get_future();
+  auto blocked_call = streaming_stub.TestMethod(req);
+  entered.wait();
+
+  EXPECT_EQ(stub.TestMethod(req).get().name(), "dude_replied");
+
+  gate.set_value();
+  blocked_call.for_each([](::tests::TestReply) {}).get();
+}
+
+TEST(server, expired_calls_are_rejected) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  std::promise<void> gate;
+  Blocking_streaming_impl blocking_srv(gate.get_future().share());
+
+  std::atomic<int> handled = 0;
+  rpc::server::Service_config service("tests.TestService");
+  service.add_method(tests::TestService::kTestService_TestMethod_name,
+                     [&](::tests::TestRequest) {
+                       ++handled;
+                       return ::tests::TestReply{};
+                     });
+
+  int server_port = 0;
+  rpc::server::Server srv(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(blocking_srv)
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  auto stats = srv.method_stats(tests::TestService::kTestService_TestMethod_name);
+  ASSERT_NE(stats, nullptr);
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub streaming_stub(&channel);
+  tests::TestService::Stub stub(&channel);
+
+  // Park the only thread of the server's queue.
+  auto entered = blocking_srv.entered.get_future();
+  auto blocked_call = streaming_stub.TestMethod({});
+  entered.wait();
+
+  rpc::client::Call_options options;
+  options.deadline = gpr_time_add(gpr_now(GPR_CLOCK_REALTIME),
+                                  gpr_time_from_millis(100, GPR_TIMESPAN));
+  auto expired_call = stub.TestMethod({}, options);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  gate.set_value();
+  blocked_call.for_each([](::tests::TestReply) {}).get();
+
+  try {
+    expired_call.get();
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_DEADLINE_EXCEEDED);
+  }
+
+  // The queue is free again: calls that can still make it get through.
+  stub.TestMethod({}).get();
+
+  EXPECT_EQ(stats->calls_expired.load(), 1U);
+  EXPECT_EQ(handled.load(), 1);
+}
+
+TEST(server, shutdown_cancels_hanging_calls) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+  Holding_impl holding_srv;
+
+  int server_port = 0;
+  auto srv = std::make_unique<rpc::server::Server>(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(holding_srv)
+          .add_listening_port("127.0.0.1:0", {}, &server_port)
+          .set_shutdown_grace_period(std::chrono::milliseconds(50)));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+  tests::TestService::Stub stub(&channel);
+
+  auto rep = stub.TestMethod({});
+  while (holding_srv.held() == 0) {
+    std::this_thread::yield();
+  }
+
+  // The handler never replies, so this only returns thanks to the grace period.
+  auto start = std::chrono::steady_clock::now();
+  srv.reset();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  EXPECT_THROW(rep.get(), rpc::Rpc_error);
+
+  // The abandoned handler's reply is dropped, rather than sent through the
+  // server that is gone.
+  holding_srv.release();
+}
@@ -3,6 +3,14 @@
 #include "generated/test.egrpc.pb.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace rpc = easy_grpc;
 
 namespace {
@@ -23,6 +31,68 @@ class Test_async_impl {
     return result;
   }
 };
+
+// Produces its replies from another thread, at the pace the stream allows.
+class Test_writer_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  Test_writer_impl(int total, std::size_t payload_size)
+      : total_(total), payload_size_(payload_size) {}
+
+  ~Test_writer_impl() {
+    if (producer_.joinable()) {
+      producer_.join();
+    }
+  }
+
+  void TestMethod(::tests::TestRequest,
+                  ::rpc::Stream_writer<::tests::TestReply> rep) {
+    producer_ = std::thread([this, rep]() mutable {
+      ::tests::TestReply msg;
+      msg.set_name(std::string(payload_size_, 'x'));
+
+      try {
+        for (int i = 0; i < total_; ++i) {
+          rep.ready().get();
+          msg.set_count(i);
+          rep.push(msg);
+          ++produced;
+        }
+        rep.complete();
+      } catch (...) {
+      }
+    });
+  }
+
+  std::atomic<int> produced = 0;
+
+ private:
+  int total_;
+  std::size_t payload_size_;
+  std::thread producer_;
+};
+
+class Test_serialized_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  explicit Test_serialized_impl(const ::tests::TestReply& msg) : msg_(msg) {}
+
+  ::rpc::Stream_future<::rpc::Serialized<::tests::TestReply>> TestMethod(
+      ::tests::TestRequest) {
+    ::rpc::Stream_promise<::rpc::Serialized<::tests::TestReply>> rep;
+    auto result = rep.get_future();
+
+    rep.push(msg_);
+    rep.push(msg_);
+    rep.complete();
+    return result;
+  }
+
+ private:
+  ::rpc::Serialized<::tests::TestReply> msg_;
+};
 }
 
 TEST(server_streaming, simple_call) {
@@ -63,3 +133,290 @@ TEST(server_streaming, simple_call) {
 
   EXPECT_EQ(all_done.get(), 3);
 }
+
+TEST(server_streaming, repeated_calls) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_async_impl async_srv;
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestServerStreamingService::get_config(async_srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  // Handlers get recycled between calls, they must come back clean.
+  for (int i = 0; i < 20; ++i) {
+    auto count = std::make_shared<int>(0);
+    auto all_done = stub.TestMethod(req).for_each([count](::tests::TestReply){
+      ++*count;
+    }).then([count](){
+      return *count;
+    });
+
+    EXPECT_EQ(all_done.get(), 3);
+  }
+
+  auto stats = server.method_stats(
+      tests::TestServerStreamingService::kTestServerStreamingService_TestMethod_name);
+  ASSERT_NE(stats, nullptr);
+  EXPECT_GT(stats->handlers_reused.load(), 0U);
+}
+
+TEST(server_streaming, shared_serialized_message) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  ::tests::TestReply msg;
+  msg.set_name("broadcast");
+  Test_serialized_impl srv(msg);
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestServerStreamingService::get_config(srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  for (int i = 0; i < 5; ++i) {
+    auto names = std::make_shared<std::vector<std::string>>();
+    auto all_done = stub.TestMethod({}).for_each([names](::tests::TestReply rep){
+      names->push_back(rep.name());
+    }).then([names](){
+      return *names;
+    });
+
+    EXPECT_EQ(all_done.get(), std::vector<std::string>(2, "broadcast"));
+  }
+}
+
+TEST(server_streaming, writer) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  Test_writer_impl srv(100, 10);
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestServerStreamingService::get_config(srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  auto next = std::make_shared<int>(0);
+  auto all_done = stub.TestMethod({}).for_each([next](::tests::TestReply rep){
+    EXPECT_EQ(rep.count(), *next);
+    ++*next;
+  }).then([next](){
+    return *next;
+  });
+
+  EXPECT_EQ(all_done.get(), 100);
+}
+
+TEST(server_streaming, writer_backpressure) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  constexpr int total = 2000;
+  Test_writer_impl srv(total, 16 * 1024);
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(tests::TestServerStreamingService::get_config(srv))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  // Stalls the client's queue on the first message, so it stops reading.
+  std::promise<void> gate;
+  auto gate_fut = gate.get_future().share();
+
+  // Replies that arrive before for_each() is attached are delivered from this
+  // thread, which must not wait on itself.
+  auto test_thread = std::this_thread::get_id();
+
+  auto received = std::make_shared<int>(0);
+  auto all_done = stub.TestMethod({}).for_each([received, gate_fut, test_thread](::tests::TestReply){
+    if (std::this_thread::get_id() != test_thread) {
+      gate_fut.wait();
+    }
+    ++*received;
+  }).then([received](){
+    return *received;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  auto produced_while_stalled = srv.produced.load();
+  EXPECT_GT(produced_while_stalled, 0);
+  EXPECT_LT(produced_while_stalled, total);
+
+  gate.set_value();
+  EXPECT_EQ(all_done.get(), total);
+}
+
+TEST(server_streaming, coalesced_writes) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  constexpr int total = 500;
+  Test_writer_impl srv(total, 100);
+
+  rpc::server::Method_options options;
+  options.stream_capacity = 64;
+  options.coalesce_writes = true;
+
+  auto service = tests::TestServerStreamingService::get_config(srv);
+  service.set_method_options(options);
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  auto next = std::make_shared<int>(0);
+  auto all_done = stub.TestMethod({}).for_each([next](::tests::TestReply rep){
+    EXPECT_EQ(rep.count(), *next);
+    ++*next;
+  }).then([next](){
+    return *next;
+  });
+
+  EXPECT_EQ(all_done.get(), total);
+}
+
+// A writer taken by reference still makes a server-streaming method.
+TEST(server_streaming, writer_by_reference) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("tests.TestServerStreamingService");
+  service.add_method(
+      "/tests.TestServerStreamingService/TestMethod",
+      [](const ::tests::TestRequest& req,
+         ::rpc::Stream_writer<::tests::TestReply>& rep) {
+        ::tests::TestReply msg;
+        msg.set_name(req.name());
+        rep.push(msg);
+        rep.push(msg);
+        rep.complete();
+      });
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("x");
+
+  auto names = std::make_shared<std::string>();
+  auto all_done = stub.TestMethod(req).for_each([names](::tests::TestReply rep){
+    *names += rep.name();
+  }).then([names](){
+    return *names;
+  });
+
+  EXPECT_EQ(all_done.get(), "xx");
+}
+
+// A handler that lets go of its writer without ending the stream fails the
+// call, instead of leaving it open.
+TEST(server_streaming, dropped_writer_fails_the_call) {
+  rpc::Environment env;
+
+  std::array<rpc::Completion_queue, 1> server_queues;
+  rpc::Completion_queue client_queue;
+
+  rpc::server::Service_config service("tests.TestServerStreamingService");
+  service.add_method(
+      "/tests.TestServerStreamingService/TestMethod",
+      [](const ::tests::TestRequest& req,
+         ::rpc::Stream_writer<::tests::TestReply> rep) {
+        ::tests::TestReply msg;
+        msg.set_name(req.name());
+        rep.push(msg);
+      });
+
+  int server_port = 0;
+  rpc::server::Server server =
+      rpc::server::Config()
+          .add_default_listening_queues(
+              {server_queues.begin(), server_queues.end()})
+          .add_service(std::move(service))
+          .add_listening_port("127.0.0.1:0", {}, &server_port);
+
+  rpc::client::Unsecure_channel channel(
+        std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestServerStreamingService::Stub stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("x");
+
+  auto all_done = stub.TestMethod(req).for_each([](::tests::TestReply){});
+
+  try {
+    all_done.get();
+    ADD_FAILURE() << "the call ended normally";
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_INTERNAL);
+  }
+}
@@ -0,0 +1,100 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rpc = easy_grpc;
+
+namespace {
+class Echo_server {
+ public:
+  Echo_server() {
+    rpc::server::Service_config service("test.Echo");
+    service.add_method("/test.Echo/Echo", [](std::string req) {
+      if (req == "fail") {
+        throw rpc::error::invalid_argument("no");
+      }
+      rpc::Promise<std::string> rep;
+      rep.set_value(req);
+      return rep.get_future();
+    });
+
+    server_ = std::make_unique<rpc::server::Server>(
+        rpc::server::Config()
+            .add_default_listening_queues({&queue_, &queue_ + 1})
+            .add_service(std::move(service))
+            .add_listening_port("127.0.0.1:0", {}, &port_));
+  }
+
+  std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+
+ private:
+  rpc::Completion_queue queue_;
+  int port_ = 0;
+  std::unique_ptr<rpc::server::Server> server_;
+};
+}  // namespace
+
+TEST(sync_call, reply_and_error) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Echo_server server;
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> echo("/test.Echo/Echo",
+                                                          &channel);
+
+  EXPECT_EQ(echo.call_sync("hi"), "hi");
+  EXPECT_EQ(echo.call_sync("again"), "again");
+
+  try {
+    echo.call_sync("fail");
+    FAIL();
+  } catch (rpc::Rpc_error& e) {
+    EXPECT_EQ(e.code(), GRPC_STATUS_INVALID_ARGUMENT);
+  }
+}
+
+// Each Environment gets fresh pluck queues.
+TEST(sync_call, new_environment) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Echo_server server;
+
+  rpc::client::Unsecure_channel channel(server.address(), &client_queue);
+  rpc::client::Method_stub<std::string, std::string> echo("/test.Echo/Echo",
+                                                          &channel);
+
+  EXPECT_EQ(echo.call_sync("hi"), "hi");
+}
+
+TEST(sync_call, many_threads) {
+  rpc::Environment env;
+  rpc::Completion_queue client_queue;
+  Echo_server server;
+
+  rpc::client::Balanced_channel channel({server.address(), server.address()},
+                                        &client_queue);
+  rpc::client::Method_stub<std::string, std::string> echo("/test.Echo/Echo",
+                                                          &channel);
+
+  std::vector<std::thread> threads;
+  std::vector<int> matches(4);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 50; ++i) {
+        auto req = std::to_string(t * 100 + i);
+        matches[t] += echo.call_sync(req) == req;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(matches, std::vector<int>(4, 50));
+}
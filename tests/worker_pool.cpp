@@ -0,0 +1,167 @@
+#include "easy_grpc/easy_grpc.h"
+
+#include "generated/test.egrpc.pb.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace rpc = easy_grpc;
+
+namespace {
+// Holds the thread it's called from until the gate opens.
+class Gated_sync_impl {
+ public:
+  using service_type = tests::TestService;
+
+  explicit Gated_sync_impl(std::shared_future<void> gate)
+      : gate_(std::move(gate)) {}
+
+  ::tests::TestReply TestMethod(::tests::TestRequest req) {
+    entered.set_value();
+    gate_.wait();
+
+    ::tests::TestReply result;
+    result.set_name(req.name() + "_replied");
+    return result;
+  }
+
+  std::promise<void> entered;
+
+ private:
+  std::shared_future<void> gate_;
+};
+
+class Test_stream_impl {
+ public:
+  using service_type = tests::TestServerStreamingService;
+
+  ::rpc::Stream_future<::tests::TestReply> TestMethod(::tests::TestRequest) {
+    ::rpc::Stream_promise<::tests::TestReply> rep;
+    auto result = rep.get_future();
+    rep.push(::tests::TestReply());
+    rep.complete();
+    return result;
+  }
+};
+}  // namespace
+
+TEST(worker_pool, runs_tasks) {
+  std::atomic<int> count = 0;
+  {
+    rpc::Worker_pool pool(2);
+    EXPECT_EQ(pool.thread_count(), 2U);
+
+    for (int i = 0; i < 100; ++i) {
+      pool.push([&] { ++count; });
+    }
+  }
+  // Queued tasks are run before the pool goes away.
+  EXPECT_EQ(count, 100);
+}
+
+TEST(worker_pool, as_future_queue) {
+  rpc::Worker_pool pool(1);
+
+  rpc::Promise<int> prom;
+  auto main_thread = std::this_thread::get_id();
+
+  auto result = prom.get_future().then(pool, [&](int v) {
+    EXPECT_NE(std::this_thread::get_id(), main_thread);
+    return v * 2;
+  });
+
+  prom.set_value(4);
+  EXPECT_EQ(result.get(), 8);
+}
+
+TEST(worker_pool, bounded) {
+  std::promise<void> gate;
+  auto gate_fut = gate.get_future().share();
+
+  rpc::Worker_pool pool(1, 1);
+
+  std::promise<void> started;
+  pool.push([&] {
+    started.set_value();
+    gate_fut.wait();
+  });
+  started.get_future().wait();
+
+  EXPECT_TRUE(pool.try_push([] {}));
+  EXPECT_FALSE(pool.try_push([] {}));
+
+  // push() runs the task right away instead of waiting for room.
+  auto pushing_thread = std::this_thread::get_id();
+  std::thread::id ran_on;
+  pool.push([&] { ran_on = std::this_thread::get_id(); });
+  EXPECT_EQ(ran_on, pushing_thread);
+
+  gate.set_value();
+}
+
+TEST(worker_pool, tasks_can_push) {
+  std::promise<void> done;
+  {
+    rpc::Worker_pool pool(1, 1);
+
+    // The second push finds the queue full, and must not wait on the only
+    // worker, which is busy running the first task.
+    pool.push([&] {
+      pool.push([] {});
+      pool.push([&] { done.set_value(); });
+    });
+    done.get_future().wait();
+  }
+}
+
+TEST(worker_pool, offloaded_sync_handler) {
+  rpc::Environment env;
+
+  rpc::Completion_queue server_queue;
+  rpc::Completion_queue client_queue;
+
+  std::promise<void> gate;
+  Gated_sync_impl gated_srv(gate.get_future().share());
+  Test_stream_impl stream_srv;
+
+  rpc::server::Method_options options;
+  options.worker_pool = std::make_shared<rpc::Worker_pool>(1);
+
+  auto gated_cfg = tests::TestService::get_config(gated_srv);
+  gated_cfg.set_method_options(options);
+  EXPECT_THROW(gated_cfg.set_method_options("/tests.TestService/Nope", options),
+               std::invalid_argument);
+
+  int server_port = 0;
+  rpc::server::Server srv(
+      rpc::server::Config()
+          .add_default_listening_queues({&server_queue, &server_queue + 1})
+          .add_service(std::move(gated_cfg))
+          .add_service(stream_srv)
+          .add_listening_port("127.0.0.1:0", {}, &server_port));
+
+  rpc::client::Unsecure_channel channel(
+      std::string("127.0.0.1:") + std::to_string(server_port), &client_queue);
+
+  tests::TestService::Stub stub(&channel);
+  tests::TestServerStreamingService::Stub stream_stub(&channel);
+
+  ::tests::TestRequest req;
+  req.set_name("dude");
+
+  auto entered = gated_srv.entered.get_future();
+  auto slow_call = stub.TestMethod(req);
+  entered.wait();
+
+  // The only thread of the server queue is still free.
+  auto count = std::make_shared<int>(0);
+  stream_stub.TestMethod(req)
+      .for_each([count](::tests::TestReply) { ++*count; })
+      .get();
+  EXPECT_EQ(*count, 1);
+
+  gate.set_value();
+  EXPECT_EQ(slow_call.get().name(), "dude_replied");
+}
@@ -65,7 +65,7 @@ void Stream_storage<Alloc, Ts...>::push(Us&&... args) {
       l.unlock();
       cb_data_.callback_->push(std::forward<Us>(args)...);
     } else {
-      fullfilled_.push_back(std::move(args)...);
+      fullfilled_.push_back(std::forward<Us>(args)...);
     }
   }
 }